@@ -0,0 +1,84 @@
+/**
+ *
+ * Allocation counts of the tree.
+ *
+ * Builds the tree of a database with createTree, frees it, saves it and
+ * loads it back, and prints the allocations and the time of every step.
+ * It is linked with the objects of src2 of the version to measure (the
+ * ones with createTree and readDatabase in main_part2.c, and saveTree and
+ * loadTree in red-black-tree.c) and run with the
+ * counter of mcount.c; the commands are in valgrind_arena.txt.
+ *
+ * Igor Dzinka / Vicent Roig, 2014.
+ *
+ */
+
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "red-black-tree.h"
+
+RBTree* createTree(char** fileList, int* nfiles);
+char** readDatabase(char *configFile, int* nfiles);
+
+static void (*snapshot)(long *, long *, long *);
+static long lastAllocs, lastFrees, lastBytes;
+static struct timespec lastTime;
+
+
+static void startStep(void){
+	if (snapshot) snapshot(&lastAllocs, &lastFrees, &lastBytes);
+	clock_gettime(CLOCK_MONOTONIC, &lastTime);
+}
+
+
+static void endStep(const char *name){
+	struct timespec now;
+	long allocs = 0, frees = 0, bytes = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	if (snapshot) snapshot(&allocs, &frees, &bytes);
+	fprintf(stderr, "==mcount== %-22s %ld allocs, %ld frees, %ld bytes allocated, %.2f ms\n", name,
+			allocs - lastAllocs, frees - lastFrees, bytes - lastBytes,
+			(now.tv_sec - lastTime.tv_sec) * 1e3 + (now.tv_nsec - lastTime.tv_nsec) * 1e-6);
+}
+
+
+int main(int argc, char **argv){
+	char **fileList;
+	int nfiles;
+	RBTree *tree;
+
+	if (argc != 3) {
+		printf("us: %s llista.cfg fitxer-arbre\n", argv[0]);
+		return 1;
+	}
+	snapshot = dlsym(RTLD_DEFAULT, "mcount_snapshot");
+
+	fileList = readDatabase(argv[1], &nfiles);
+	if (fileList == NULL) return 1;
+
+	startStep();
+	tree = createTree(fileList, &nfiles);
+	endStep("createTree:");
+	saveTree(tree, argv[2]);
+
+	startStep();
+	deleteTree(tree);
+	free(tree);
+	endStep("deleteTree:");
+
+	startStep();
+	tree = loadTree(argv[2]);
+	endStep("loadTree:");
+	if (tree == NULL) return 1;
+
+	startStep();
+	deleteTree(tree);
+	free(tree);
+	endStep("deleteTree (carregat):");
+
+	return 0;
+}
@@ -0,0 +1,103 @@
+/**
+ *
+ * Allocation counter.
+ *
+ * Counts the calls to malloc, calloc, realloc and free of a program and
+ * prints the total at exit, in the format of the heap summary of
+ * valgrind. It is loaded with LD_PRELOAD, for the machines without
+ * valgrind:
+ *
+ *   gcc -Wall -O2 -shared -fPIC mcount.c -o mcount.so -ldl
+ *   LD_PRELOAD=./mcount.so ./practica4
+ *
+ * The program may read the counters with mcount_snapshot (found with
+ * dlsym, so that it also runs without the counter), as mcount-tree.c does.
+ *
+ * Igor Dzinka / Vicent Roig, 2014.
+ *
+ */
+
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+
+static atomic_long numAllocs, numFrees, numBytes;
+
+static void *(*realMalloc)(size_t);
+static void *(*realCalloc)(size_t, size_t);
+static void *(*realRealloc)(void *, size_t);
+static void (*realFree)(void *);
+
+/**
+ * dlsym crida calloc abans que tinguem el calloc real: aquestes reserves
+ * surten d'aquest buffer i no es compten ni s'alliberen.
+ */
+static char bootBuffer[65536];
+static size_t bootUsed = 0;
+
+
+static void initCounter(void){
+	realMalloc = dlsym(RTLD_NEXT, "malloc");
+	realRealloc = dlsym(RTLD_NEXT, "realloc");
+	realFree = dlsym(RTLD_NEXT, "free");
+	realCalloc = dlsym(RTLD_NEXT, "calloc");
+}
+
+
+void *malloc(size_t size){
+	if (realMalloc == NULL) initCounter();
+	numAllocs++;
+	numBytes += size;
+	return realMalloc(size);
+}
+
+
+void *calloc(size_t num, size_t size){
+	void *p;
+
+	if (realCalloc == NULL) {	//crida de dlsym
+		p = bootBuffer + bootUsed;
+		bootUsed += (num * size + 15) & ~((size_t) 15);
+		return p;
+	}
+	numAllocs++;
+	numBytes += num * size;
+	return realCalloc(num, size);
+}
+
+
+void *realloc(void *ptr, size_t size){
+	if (realRealloc == NULL) initCounter();
+	if (ptr == NULL) numAllocs++;
+	numBytes += size;
+	return realRealloc(ptr, size);
+}
+
+
+void free(void *ptr){
+	if (ptr == NULL) return;
+	if ((char *) ptr >= bootBuffer && (char *) ptr < bootBuffer + sizeof(bootBuffer)) return;
+	if (realFree == NULL) initCounter();
+	numFrees++;
+	realFree(ptr);
+}
+
+
+/**
+ *
+ * Returns the counters so far: allocations, frees and bytes allocated.
+ *
+ */
+void mcount_snapshot(long *allocs, long *frees, long *bytes){
+	*allocs = numAllocs;
+	*frees = numFrees;
+	*bytes = numBytes;
+}
+
+
+__attribute__((destructor)) static void printSummary(void){
+	fprintf(stderr, "==mcount== total heap usage: %ld allocs, %ld frees, %ld bytes allocated\n",
+			(long) numAllocs, (long) numFrees, (long) numBytes);
+}
@@ -0,0 +1,134 @@
+/**
+ *
+ * Arena implementation.
+ *
+ * Bump allocator over a singly linked list of blocks. Allocation only
+ * advances an offset inside the current block; when it does not fit a
+ * new block is requested. Memory is returned to the system block by
+ * block when the arena is deleted.
+ *
+ * Igor Dzinka / Vicent Roig, 2014.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * We include the arena.h header. Note the double
+ * quotes.
+ */
+#include "arena.h"
+
+#define ARENA_ALIGN sizeof(void *)
+
+
+/**
+ *
+ * Initialize an empty arena. No memory is requested until the
+ * first allocation.
+ *
+ */
+void initArena(Arena *arena, size_t blockSize){
+	arena->first = NULL;
+	arena->blockSize = blockSize ? blockSize : ARENA_BLOCKSIZE;
+	arena->numBlocks = 0;
+}
+
+
+/**
+ *
+ * Returns size bytes aligned to a pointer boundary. Requests bigger than
+ * the block size get a block of their own.
+ *
+ */
+void *allocArena(Arena *arena, size_t size){
+	ArenaBlock *block = arena->first;
+	size_t offset, blockSize;
+
+	size = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+
+	if (block == NULL || block->used + size > block->size) {
+		blockSize = size > arena->blockSize ? size : arena->blockSize;
+
+		block = malloc(sizeof(ArenaBlock) + blockSize);
+		if (block == NULL) {
+			printf("insufficient memory (allocArena)\n");
+			exit(1);
+		}
+		block->used = 0;
+		block->size = blockSize;
+		block->next = arena->first;
+
+		arena->first = block;
+		arena->numBlocks++;
+	}
+
+	offset = block->used;
+	block->used += size;
+	return block->data + offset;
+}
+
+
+/**
+ *
+ * Copies len characters of string into the arena and appends the end of
+ * string. The string does not need to be null terminated.
+ *
+ */
+char *copyStringArena(Arena *arena, const char *string, int len){
+	char *copy = allocArena(arena, len + 1);
+
+	memcpy(copy, string, len);
+	copy[len] = '\0';
+	return copy;
+}
+
+
+/**
+ *
+ * Moves all the blocks of src to dst, so that the memory of src is
+ * released when dst is deleted. The blocks are placed after the current
+ * block of dst, and new allocations keep using it. src is left empty.
+ *
+ */
+void moveArena(Arena *dst, Arena *src){
+	ArenaBlock *last;
+
+	if (src->first == NULL) return;
+
+	if (dst->first == NULL) {
+		dst->first = src->first;
+	} else {
+		last = src->first;
+		while (last->next != NULL) last = last->next;
+		last->next = dst->first->next;
+		dst->first->next = src->first;
+	}
+	dst->numBlocks += src->numBlocks;
+
+	src->first = NULL;
+	src->numBlocks = 0;
+}
+
+
+/**
+ *
+ * Frees all the blocks of the arena. Every pointer previously returned
+ * by the arena becomes invalid.
+ *
+ */
+void deleteArena(Arena *arena){
+	ArenaBlock *current, *next;
+
+	current = arena->first;
+	while (current != NULL) {
+		next = current->next;
+		free(current);
+		current = next;
+	}
+
+	arena->first = NULL;
+	arena->numBlocks = 0;
+}
@@ -0,0 +1,57 @@
+/**
+ *
+ * Arena header
+ *
+ * Include this file in order to be able to call the
+ * functions available in arena.c. An arena hands out
+ * memory from large blocks and releases all of it at
+ * once, so the callers do not need a free per object.
+ *
+ * Igor Dzinka / Vicent Roig, 2014.
+ *
+ */
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+/**
+ *
+ * Default size of each block requested to malloc.
+ *
+ */
+#define ARENA_BLOCKSIZE  (64 * 1024)
+
+/**
+ *
+ * Each block keeps the bytes already handed out in "used". Objects
+ * are never moved, so pointers returned by the arena stay valid until
+ * the whole arena is deleted.
+ *
+ */
+typedef struct ArenaBlock_ {
+	struct ArenaBlock_ *next;
+	size_t used;
+	size_t size;
+	char data[];
+} ArenaBlock;
+
+typedef struct Arena_ {
+	ArenaBlock *first;		/* bloc actual, on es fan les reserves */
+	size_t blockSize;		/* tamany per defecte dels blocs */
+	int numBlocks;			/* nombre de blocs reservats */
+} Arena;
+
+/**
+ *
+ * Function heders we want to make visible so that they
+ * can be called from any other file.
+ *
+ */
+void initArena(Arena *arena, size_t blockSize);
+void *allocArena(Arena *arena, size_t size);
+char *copyStringArena(Arena *arena, const char *string, int len);
+void moveArena(Arena *dst, Arena *src);
+void deleteArena(Arena *arena);
+
+#endif
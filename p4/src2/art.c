@@ -0,0 +1,422 @@
+/**
+ *
+ * Adaptive radix tree implementation.
+ *
+ * Based on "The Adaptive Radix Tree: ARTful Indexing for Main-Memory
+ * Databases" (Leis, Kemper, Neumann, 2013). Only insertions are needed:
+ * the tree is built from the words of a red-black tree and then it is
+ * only read. The prefixes of the nodes are not copied: they point into
+ * the key of one of the words below the node.
+ *
+ * Igor Dzinka / Vicent Roig, 2014.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/**
+ * We include the art.h header. Note the double
+ * quotes.
+ */
+#include "art.h"
+
+#define IS_LEAF(p)   (((uintptr_t) (p)) & 1)
+#define MAKE_LEAF(d) ((void *) (((uintptr_t) (d)) | 1))
+#define LEAF_DATA(p) ((RBData *) (((uintptr_t) (p)) & ~(uintptr_t) 1))
+#define LEAF_KEY(p)  ((const unsigned char *) LEAF_DATA(p)->primary_key)
+
+static const size_t nodeSize[4] = { sizeof(ArtNode4), sizeof(ArtNode16), sizeof(ArtNode48), sizeof(ArtNode256) };
+
+
+/**
+ *
+ * Initialize an empty tree.
+ *
+ */
+void initArt(Art *art){
+	art->root = NULL;
+	art->numKeys = 0;
+	art->memory = 0;
+	initArena(&(art->arena), 0);
+}
+
+
+static ArtNode *allocNode(Art *art, int type){
+	ArtNode *node = allocArena(&(art->arena), nodeSize[type]);
+
+	memset(node, 0, nodeSize[type]);
+	node->type = type;
+	art->memory += nodeSize[type];
+	return node;
+}
+
+
+/**
+ *
+ * Returns the slot of the child of node for byte c, NULL if there is none.
+ *
+ */
+static void **findChild(ArtNode *node, unsigned char c){
+	ArtNode4 *n4;
+	ArtNode16 *n16;
+	ArtNode48 *n48;
+	ArtNode256 *n256;
+	int i;
+
+	switch (node->type) {
+	case ART_NODE4:
+		n4 = (ArtNode4 *) node;
+		for (i = 0; i < node->numChildren; i++)
+			if (n4->keys[i] == c) return &(n4->children[i]);
+		return NULL;
+
+	case ART_NODE16:
+		n16 = (ArtNode16 *) node;
+#ifdef __SSE2__
+		// les 16 claus es comparen de cop
+		i = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(c), _mm_loadu_si128((__m128i *) n16->keys)));
+		i &= (1 << node->numChildren) - 1;
+		return i ? &(n16->children[__builtin_ctz(i)]) : NULL;
+#else
+		for (i = 0; i < node->numChildren; i++)
+			if (n16->keys[i] == c) return &(n16->children[i]);
+		return NULL;
+#endif
+
+	case ART_NODE48:
+		n48 = (ArtNode48 *) node;
+		return n48->index[c] ? &(n48->children[n48->index[c] - 1]) : NULL;
+
+	default:
+		n256 = (ArtNode256 *) node;
+		return n256->children[c] ? &(n256->children[c]) : NULL;
+	}
+}
+
+
+/**
+ *
+ * Replaces the full node *ref by a bigger one with the same children.
+ * The old node stays in the arena, but it is not counted as used memory.
+ *
+ */
+static ArtNode *growNode(Art *art, void **ref){
+	ArtNode *node = *ref, *bigger;
+	ArtNode4 *n4 = (ArtNode4 *) node;
+	ArtNode16 *n16 = (ArtNode16 *) node;
+	ArtNode48 *n48 = (ArtNode48 *) node;
+	int i;
+
+	bigger = allocNode(art, node->type + 1);
+	bigger->prefix = node->prefix;
+	bigger->prefixLen = node->prefixLen;
+	bigger->numChildren = node->numChildren;
+
+	switch (node->type) {
+	case ART_NODE4:
+		memcpy(((ArtNode16 *) bigger)->keys, n4->keys, 4);
+		memcpy(((ArtNode16 *) bigger)->children, n4->children, 4 * sizeof(void *));
+		break;
+	case ART_NODE16:
+		for (i = 0; i < 16; i++) {
+			((ArtNode48 *) bigger)->index[n16->keys[i]] = i + 1;
+			((ArtNode48 *) bigger)->children[i] = n16->children[i];
+		}
+		break;
+	default:
+		for (i = 0; i < 256; i++)
+			if (n48->index[i]) ((ArtNode256 *) bigger)->children[i] = n48->children[n48->index[i] - 1];
+		break;
+	}
+
+	art->memory -= nodeSize[node->type];
+	*ref = bigger;
+	return bigger;
+}
+
+
+/**
+ *
+ * Adds child for byte c to the node *ref, which does not have it. The
+ * keys of the nodes of 4 and 16 are kept sorted.
+ *
+ */
+static void addChild(Art *art, void **ref, unsigned char c, void *child){
+	ArtNode *node = *ref;
+	ArtNode4 *n4;
+	ArtNode16 *n16;
+	ArtNode48 *n48;
+	int i;
+
+	if ((node->type == ART_NODE4 && node->numChildren == 4) || (node->type == ART_NODE16 && node->numChildren == 16) ||
+			(node->type == ART_NODE48 && node->numChildren == 48))
+		node = growNode(art, ref);
+
+	switch (node->type) {
+	case ART_NODE4:
+		n4 = (ArtNode4 *) node;
+		for (i = node->numChildren; i > 0 && n4->keys[i-1] > c; i--) {
+			n4->keys[i] = n4->keys[i-1];
+			n4->children[i] = n4->children[i-1];
+		}
+		n4->keys[i] = c;
+		n4->children[i] = child;
+		break;
+	case ART_NODE16:
+		n16 = (ArtNode16 *) node;
+		for (i = node->numChildren; i > 0 && n16->keys[i-1] > c; i--) {
+			n16->keys[i] = n16->keys[i-1];
+			n16->children[i] = n16->children[i-1];
+		}
+		n16->keys[i] = c;
+		n16->children[i] = child;
+		break;
+	case ART_NODE48:
+		n48 = (ArtNode48 *) node;
+		n48->children[node->numChildren] = child;	//no s'esborra mai: les posicions ocupades son les primeres
+		n48->index[c] = node->numChildren + 1;
+		break;
+	default:
+		((ArtNode256 *) node)->children[c] = child;
+		break;
+	}
+	node->numChildren++;
+}
+
+
+/**
+ *
+ * Inserts the word of data below *ref, whose first depth bytes are
+ * already matched.
+ *
+ */
+static void insertRecursive(Art *art, void **ref, RBData *data, const unsigned char *key, int depth){
+	const unsigned char *other;
+	ArtNode *node = *ref, *split;
+	void **child;
+	int p;
+
+	if (node == NULL) {
+		*ref = MAKE_LEAF(data);
+		art->numKeys++;
+		return;
+	}
+
+	if (IS_LEAF(node)) {
+		// dues paraules: un node de 4 amb els bytes comuns com a prefix
+		other = LEAF_KEY(node);
+		for (p = 0; other[depth + p] == key[depth + p]; p++)
+			if (key[depth + p] == '\0') return;	//ja hi es
+
+		split = allocNode(art, ART_NODE4);
+		split->prefix = key + depth;
+		split->prefixLen = p;
+		*ref = split;
+		addChild(art, ref, other[depth + p], node);
+		addChild(art, ref, key[depth + p], MAKE_LEAF(data));
+		art->numKeys++;
+		return;
+	}
+
+	for (p = 0; p < node->prefixLen && node->prefix[p] == key[depth + p]; p++);
+	if (p < node->prefixLen) {
+		// el prefix es parteix: un node nou amb la part comuna
+		split = allocNode(art, ART_NODE4);
+		split->prefix = node->prefix;
+		split->prefixLen = p;
+		*ref = split;
+		addChild(art, ref, node->prefix[p], node);
+		addChild(art, ref, key[depth + p], MAKE_LEAF(data));
+
+		node->prefix += p + 1;
+		node->prefixLen -= p + 1;
+		art->numKeys++;
+		return;
+	}
+	depth += node->prefixLen;
+
+	child = findChild(node, key[depth]);
+	if (child == NULL) {
+		addChild(art, ref, key[depth], MAKE_LEAF(data));
+		art->numKeys++;
+	} else if (key[depth] != '\0') {	//sota el '\0' nomes hi pot haver la mateixa paraula
+		insertRecursive(art, child, data, key, depth + 1);
+	}
+}
+
+
+/**
+ *
+ * Inserts the word of data. The data (and its key) is not copied, so it
+ * has to live as long as the tree.
+ *
+ */
+void insertArt(Art *art, RBData *data){
+	insertRecursive(art, &(art->root), data, (const unsigned char *) data->primary_key, 0);
+}
+
+
+/**
+ *
+ * Builds the tree with all the words of a red-black tree.
+ *
+ */
+void buildArt(Art *art, RBTree *tree){
+	Node *node;
+
+	initArt(art);
+	for (node = firstNode(tree); node != NULL; node = nextNode(node)) insertArt(art, node->data);
+}
+
+
+/**
+ *
+ * Finds the data of a word, NULL if it is not in the tree. The bytes of
+ * the word are compared one by one while going down; only the rest of
+ * the word is compared once a leaf is reached.
+ *
+ */
+RBData *findArt(Art *art, const char *primary_key){
+	const unsigned char *key = (const unsigned char *) primary_key;
+	void *node = art->root, **child;
+	ArtNode *inner;
+	int p, depth = 0, len = strlen(primary_key);
+
+	while (node != NULL) {
+		if (IS_LEAF(node)) {
+			if (depth > len) return LEAF_DATA(node);	//s'ha passat pel '\0'
+			return strcmp((const char *) LEAF_KEY(node) + depth, primary_key + depth) == 0 ? LEAF_DATA(node) : NULL;
+		}
+
+		inner = node;
+		for (p = 0; p < inner->prefixLen; p++)
+			if (inner->prefix[p] != key[depth + p]) return NULL;
+		depth += inner->prefixLen;
+
+		child = findChild(inner, key[depth]);
+		if (child == NULL) return NULL;
+		node = *child;
+		depth++;
+	}
+	return NULL;
+}
+
+
+/**
+ *
+ * Places the iterator before the first word that starts with prefix (all
+ * the words if prefix is NULL or empty). It goes down while the prefix
+ * lasts; the words are the leaves of the subtree where it ends.
+ *
+ */
+void initArtIterator(ArtIterator *it, Art *art, const char *prefix){
+	const unsigned char *key = (const unsigned char *) (prefix ? prefix : "");
+	void *node = art->root, **child;
+	ArtNode *inner;
+	int p, depth = 0, len = strlen((const char *) key);
+
+	it->depth = 0;
+	while (node != NULL) {
+		if (IS_LEAF(node)) {
+			if (strncmp((const char *) LEAF_KEY(node), (const char *) key, len) == 0) break;
+			return;
+		}
+
+		inner = node;
+		for (p = 0; p < inner->prefixLen && depth + p < len; p++)
+			if (inner->prefix[p] != key[depth + p]) return;
+		if (depth + inner->prefixLen >= len) break;	//tot el subarbre comença pel prefix
+		depth += inner->prefixLen;
+
+		child = findChild(inner, key[depth]);
+		if (child == NULL) return;
+		node = *child;
+		depth++;
+	}
+
+	if (node != NULL) {
+		it->node[0] = node;
+		it->next[0] = 0;
+		it->depth = 1;
+	}
+}
+
+
+/**
+ *
+ * Returns the next child of node in byte order, starting at position
+ * *next, and advances *next. NULL when there are no more.
+ *
+ */
+static void *nextChild(ArtNode *node, int *next){
+	ArtNode48 *n48;
+	ArtNode256 *n256;
+	int c;
+
+	switch (node->type) {
+	case ART_NODE4:
+		return *next < node->numChildren ? ((ArtNode4 *) node)->children[(*next)++] : NULL;
+	case ART_NODE16:
+		return *next < node->numChildren ? ((ArtNode16 *) node)->children[(*next)++] : NULL;
+	case ART_NODE48:
+		n48 = (ArtNode48 *) node;
+		while ((c = (*next)++) < 256)
+			if (n48->index[c]) return n48->children[n48->index[c] - 1];
+		return NULL;
+	default:
+		n256 = (ArtNode256 *) node;
+		while ((c = (*next)++) < 256)
+			if (n256->children[c]) return n256->children[c];
+		return NULL;
+	}
+}
+
+
+/**
+ *
+ * Returns the next word in alphabetical order, NULL at the end.
+ *
+ */
+RBData *nextArt(ArtIterator *it){
+	void *node, *child;
+	int top;
+
+	while (it->depth > 0) {
+		top = it->depth - 1;
+		node = it->node[top];
+		if (IS_LEAF(node)) {
+			it->depth--;
+			return LEAF_DATA(node);
+		}
+
+		child = nextChild(node, &(it->next[top]));
+		if (child == NULL) {
+			it->depth--;
+			continue;
+		}
+		it->node[it->depth] = child;
+		it->next[it->depth] = 0;
+		it->depth++;
+	}
+	return NULL;
+}
+
+
+/**
+ *
+ * Frees all the nodes. The data belong to the red-black tree and are not
+ * freed.
+ *
+ */
+void deleteArt(Art *art){
+	deleteArena(&(art->arena));
+	art->root = NULL;
+	art->numKeys = 0;
+	art->memory = 0;
+}
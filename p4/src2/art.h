@@ -0,0 +1,103 @@
+/**
+ *
+ * Adaptive radix tree header
+ *
+ * Include this file in order to be able to call the
+ * functions available in art.c. We include
+ * here only those information we want to make visible
+ * to other files.
+ *
+ * Igor Dzinka / Vicent Roig, 2014.
+ *
+ */
+#ifndef ART_H
+#define ART_H
+
+#include "red-black-tree.h"
+
+/**
+ *
+ * Adaptive radix tree (ART) over the words. The tree goes down one byte
+ * of the word per level, with inner nodes of 4, 16, 48 or 256 children
+ * depending on how many bytes follow a prefix. The bytes shared by all
+ * the words below a node are kept once, in the node (path compression),
+ * so no word is compared with strcmp while going down. The words end
+ * with their '\0', so no word is a prefix of another, and the leaves are
+ * the RBData of the tree with the lowest bit of the pointer set.
+ *
+ */
+#if MAX_WORDCHR >= 256
+#error "ART: prefixLen es un unsigned char, MAX_WORDCHR ha de ser menor que 256"
+#endif
+
+#define ART_NODE4   0
+#define ART_NODE16  1
+#define ART_NODE48  2
+#define ART_NODE256 3
+
+typedef struct ArtNode_ {
+	unsigned char type;
+	unsigned char prefixLen;
+	unsigned short numChildren;
+	const unsigned char *prefix;	/* bytes compartits, dins d'una de les paraules */
+} ArtNode;
+
+typedef struct ArtNode4_ {
+	ArtNode n;
+	unsigned char keys[4];			/* ordenades */
+	void *children[4];
+} ArtNode4;
+
+typedef struct ArtNode16_ {
+	ArtNode n;
+	unsigned char keys[16];			/* ordenades */
+	void *children[16];
+} ArtNode16;
+
+typedef struct ArtNode48_ {
+	ArtNode n;
+	unsigned char index[256];		/* posicio+1 a children, 0 si no hi es */
+	void *children[48];
+} ArtNode48;
+
+typedef struct ArtNode256_ {
+	ArtNode n;
+	void *children[256];
+} ArtNode256;
+
+typedef struct Art_ {
+	void *root;
+	int numKeys;
+	size_t memory;			/* bytes dels nodes en us */
+	Arena arena;
+} Art;
+
+/**
+ *
+ * Iterator over the words of the tree in alphabetical order. The stack
+ * keeps the path from the root; a word has at most MAX_WORDCHR + 1 bytes.
+ *
+ */
+#define ART_MAXDEPTH (MAX_WORDCHR + 3)
+
+typedef struct ArtIterator_ {
+	void *node[ART_MAXDEPTH];
+	int next[ART_MAXDEPTH];		/* seguent fill a visitar de cada node */
+	int depth;
+} ArtIterator;
+
+/**
+ *
+ * Function heders we want to make visible so that they
+ * can be called from any other file.
+ *
+ */
+void initArt(Art *art);
+void insertArt(Art *art, RBData *data);
+void buildArt(Art *art, RBTree *tree);
+RBData *findArt(Art *art, const char *primary_key);
+void initArtIterator(ArtIterator *it, Art *art, const char *prefix);
+RBData *nextArt(ArtIterator *it);
+void deleteArt(Art *art);
+
+#endif
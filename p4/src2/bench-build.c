@@ -0,0 +1,150 @@
+/* * * * * * * * * * * * * * * * * * * * *
+ *			[SO2] - PRACTICA 4			 *
+ * +-----------------------------------+ *
+ *	authors: Igor Dzinka / Vicent Roig	 *
+ * * * * * * * * * * * * * * * * * * * * */
+
+/**
+ *
+ * Benchmark of the ways of building the index (see builder.h): the static
+ * split of src0, the shared counter of src1, the producers and consumers
+ * of src2 and the tree of merges. Each one is run with 1 to maxThreads
+ * threads, several times, on the files of a database. It prints, as CSV
+ * or JSON, the best and the mean wall time, the files and megabytes per
+ * second, and the speedup and the parallel efficiency with respect to
+ * the same strategy with one thread. Every index is compared with the
+ * first one built: all of them have to be identical.
+ *
+ *   ./bench-build [-t maxThreads] [-r repeticions] [-j] ../database/llista.cfg
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "builder.h"
+#include "scheduler.h"
+
+#define NREPEAT 3			// repeticions per defecte de cada mesura
+
+static const BuildStrategy strategies[] = { BUILD_STATIC, BUILD_DYNAMIC, BUILD_PIPELINE, BUILD_REDUCE };
+static const char *strategyNames[] = { "static", "dynamic", "pipeline", "reduce" };
+#define NSTRATEGIES (int) (sizeof(strategies) / sizeof(strategies[0]))
+
+
+static double now(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+/**
+ *
+ * Returns 1 if both indexes have the same words, with the same files and
+ * counters, and 0 otherwise.
+ *
+ */
+static int sameIndex(Index *a, Index *b){
+	IndexIterator ita, itb;
+	RBData *da, *db;
+
+	initIndexIterator(&ita, a);
+	initIndexIterator(&itb, b);
+	while (1) {
+		da = nextIndex(&ita);
+		db = nextIndex(&itb);
+		if (da == NULL || db == NULL) return da == db;
+
+		if (strcmp(da->primary_key, db->primary_key) != 0 || da->numFiles != db->numFiles ||
+				da->postings.len != db->postings.len ||
+				memcmp(da->postings.bytes, db->postings.bytes, da->postings.len) != 0)
+			return 0;
+	}
+}
+
+
+int main(int argc, char **argv){
+	int opt, s, t, rep, i, nfiles, maxThreads, repeats = NREPEAT, json = 0, identical, rc = 0, first = 1;
+	double start, elapsed, best, total, base = 0, megabytes = 0;
+	Index *reference = NULL, *index;
+	char **fileList;
+	struct stat st;
+
+	maxThreads = getNumProcessors();
+	while ((opt = getopt(argc, argv, "t:r:j")) != -1) {
+		switch (opt) {
+			case 't': maxThreads = atoi(optarg); break;
+			case 'r': repeats = atoi(optarg); break;
+			case 'j': json = 1; break;
+			default:
+				printf("Us: %s [-t fils] [-r repeticions] [-j] fitxer-cfg\n", argv[0]);
+				return 1;
+		}
+	}
+	if (optind != argc - 1 || maxThreads < 1 || repeats < 1) {
+		printf("Us: %s [-t fils] [-r repeticions] [-j] fitxer-cfg\n", argv[0]);
+		return 1;
+	}
+
+	setBuildVerbose(0);
+	if ((fileList = readDatabase(argv[optind], &nfiles)) == NULL) return 1;
+	for (i = 0; i < nfiles; i++)
+		if (stat(fileList[i], &st) == 0) megabytes += st.st_size / 1e6;
+
+	if (json) printf("[\n");
+	else printf("strategy,threads,repeats,best_ms,mean_ms,files_per_s,mb_per_s,speedup,efficiency,identical\n");
+
+	for (s = 0; s < NSTRATEGIES; s++) {
+		for (t = 1; t <= maxThreads; t++) {
+			setBuildThreads(t);
+			best = 0;
+			total = 0;
+			identical = 1;
+
+			for (rep = 0; rep < repeats; rep++) {
+				start = now();
+				index = buildIndex(strategies[s], fileList, &nfiles);
+				elapsed = now() - start;
+				if (index == NULL) {
+					printf("ERROR: no s'ha pogut construir l'index (%s, %d fils)\n", strategyNames[s], t);
+					return 1;
+				}
+
+				total += elapsed;
+				if (rep == 0 || elapsed < best) best = elapsed;
+
+				if (reference == NULL) reference = index;	//el primer es la referencia
+				else {
+					if (!sameIndex(reference, index)) identical = 0;
+					deleteIndex(index);
+					free(index);
+				}
+			}
+			if (t == 1) base = best;
+			if (!identical) rc = 1;
+
+			if (json) {
+				printf("%s  {\"strategy\": \"%s\", \"threads\": %d, \"repeats\": %d, \"best_ms\": %.3f, \"mean_ms\": %.3f, "
+						"\"files_per_s\": %.1f, \"mb_per_s\": %.2f, \"speedup\": %.3f, \"efficiency\": %.3f, \"identical\": %s}",
+						first ? "" : ",\n", strategyNames[s], t, repeats, best * 1e3, total / repeats * 1e3,
+						nfiles / best, megabytes / best, base / best, base / best / t, identical ? "true" : "false");
+			} else {
+				printf("%s,%d,%d,%.3f,%.3f,%.1f,%.2f,%.3f,%.3f,%d\n", strategyNames[s], t, repeats, best * 1e3,
+						total / repeats * 1e3, nfiles / best, megabytes / best, base / best, base / best / t, identical);
+			}
+			first = 0;
+		}
+	}
+	if (json) printf("\n]\n");
+
+	deleteIndex(reference);
+	free(reference);
+	for (i = 0; i < nfiles; i++) free(fileList[i]);
+	free(fileList);
+
+	return rc;
+}
@@ -0,0 +1,176 @@
+/* * * * * * * * * * * * * * * * * * * * *
+ *			[SO2] - PRACTICA 4			 *
+ * +-----------------------------------+ *
+ *	authors: Igor Dzinka / Vicent Roig	 *
+ * * * * * * * * * * * * * * * * * * * * */
+
+/**
+ *
+ * Benchmark of the word lookups. It loads an index saved with the menu and
+ * looks for all its words, in random order, plus as many words that are
+ * not in the index. The words are looked for one by one with findIndex and
+ * in batches of several sizes with lookupWords, first on the mapped file
+ * as loadIndex leaves it, then on the trees and then on the frozen index.
+ * It prints the queries per second of each method and the memory of the
+ * lookup structure, and checks that all of them find the words of the
+ * index and only them. The structure of the frozen index is chosen
+ * when building (see INDEX_LOOKUP in index.h):
+ *
+ *   ./bench-query ../proves/llista.idx
+ *   make bench-query BENCH_CFLAGS="-Wall -Werror -O2 -DINDEX_LOOKUP=LOOKUP_ART"
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "query.h"
+
+#define NREPEAT 20			// nombre de repeticions per metode
+
+static const int batchSizes[] = { 16, 256, 4096, 0 };	// 0: totes les paraules en un lot
+#define NBATCHES (int) (sizeof(batchSizes) / sizeof(batchSizes[0]))
+
+
+static double now(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+static void printLookupMemory(Index *index, int numWords){
+	size_t bytes = getIndexLookupMemory(index);
+
+	printf("memoria de consulta: %zu bytes (%.1f bytes/paraula)\n", bytes, (double) bytes / numWords);
+}
+
+
+// la paraula es a l'index si ha de ser-hi, amb la mateixa clau
+static int wrongResult(RBData *data, Query *query, char expected){
+	if (!expected) return data != NULL;
+	return data == NULL || strcmp(data->primary_key, query->word) != 0;
+}
+
+
+/**
+ *
+ * Looks for all the queries one by one and in batches, and checks the
+ * results against expected. Returns 1 if some result is wrong.
+ *
+ */
+static int runLookups(Index *index, Query *queries, char *expected, int numQueries){
+	const char *name = index->file ? "findIndex/file" : index->frozen ? "findIndex/frozen" : "findIndex";
+	int i, k, n, rep, size, rc = 0;
+	double start, t;
+
+	// una a una
+	start = now();
+	for (rep = 0; rep < NREPEAT; rep++)
+		for (i = 0; i < numQueries; i++)
+			if (wrongResult(findIndex(index, queries[i].word), &(queries[i]), expected[i])) rc = 1;
+	t = (now() - start) / NREPEAT;
+	if (rc) printf("ERROR: %s dona resultats diferents\n", name);
+	printf("%-18s %8.2f ms  %12.0f consultes/s\n", name, t * 1e3, numQueries / t);
+
+	// per lots; l'index congelat no ordena els lots, el tamany no hi hauria d'influir
+	for (k = 0; k < NBATCHES; k++) {
+		size = batchSizes[k] ? batchSizes[k] : numQueries;
+
+		start = now();
+		for (rep = 0; rep < NREPEAT; rep++)
+			for (i = 0; i < numQueries; i += size) {
+				n = (numQueries - i < size) ? numQueries - i : size;
+				lookupWords(index, queries + i, n);
+			}
+		t = (now() - start) / NREPEAT;
+
+		for (i = 0; i < numQueries; i++)
+			if (wrongResult(queries[i].data, &(queries[i]), expected[i])) {
+				printf("ERROR: '%s' dona un resultat diferent en lots de %d\n", queries[i].word, size);
+				rc = 1;
+				break;
+			}
+
+		printf("lookupWords/%-6d %8.2f ms  %12.0f consultes/s\n", size, t * 1e3, numQueries / t);
+	}
+
+	return rc;
+}
+
+
+int main(int argc, char **argv){
+	Index *index;
+	IndexIterator it;
+	RBData *data;
+	Query *queries, tmp;
+	char *expected, c;
+	int i, k, numWords, numQueries, rc = 0;
+	double start;
+
+	if (argc != 2) {
+		printf("Us: %s fitxer-index\n", argv[0]);
+		return 1;
+	}
+	start = now();
+	if ((index = loadIndex(argv[1])) == NULL) {
+		printf("No s'ha pogut carregar l'index '%s'\n", argv[1]);
+		return 1;
+	}
+	printf("loadIndex: %.2f ms\n", (now() - start) * 1e3);
+
+	// totes les paraules de l'index i, per cadascuna, una que no hi es
+	numWords = getIndexNumNodes(index);
+	numQueries = 2 * numWords;
+	queries = malloc(sizeof(Query) * numQueries);
+	expected = malloc(numQueries);
+
+	i = 0;
+	initIndexIterator(&it, index);
+	while ((data = nextIndex(&it)) != NULL) {
+		expected[i] = 1;
+		queries[i++].word = strdup(data->primary_key);
+		expected[i] = 0;
+		queries[i].word = malloc(strlen(data->primary_key) + 2);
+		sprintf(queries[i++].word, "%s#", data->primary_key);
+	}
+
+	srand(1);
+	for (i = numQueries - 1; i > 0; i--) {
+		k = rand() % (i + 1);
+		tmp = queries[i];
+		queries[i] = queries[k];
+		queries[k] = tmp;
+		c = expected[i];
+		expected[i] = expected[k];
+		expected[k] = c;
+	}
+
+	printf("%d paraules a l'index, %d consultes (la meitat no hi son)\n", numWords, numQueries);
+
+	printLookupMemory(index, numWords);
+	rc |= runLookups(index, queries, expected, numQueries);
+
+	start = now();
+	thawIndex(index);	//es fan els arbres a partir del fitxer
+	printf("thawIndex: %.2f ms\n", (now() - start) * 1e3);
+
+	printLookupMemory(index, numWords);
+	rc |= runLookups(index, queries, expected, numQueries);
+
+	start = now();
+	freezeIndex(index);
+	printf("freezeIndex: %.2f ms\n", (now() - start) * 1e3);
+
+	printLookupMemory(index, numWords);
+	rc |= runLookups(index, queries, expected, numQueries);
+
+	for (i = 0; i < numQueries; i++) free(queries[i].word);
+	free(queries);
+	free(expected);
+	deleteIndex(index);
+	free(index);
+
+	return rc;
+}
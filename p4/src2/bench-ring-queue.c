@@ -0,0 +1,196 @@
+/* * * * * * * * * * * * * * * * * * * * *
+ *			[SO2] - PRACTICA 4			 *
+ * +-----------------------------------+ *
+ *	authors: Igor Dzinka / Vicent Roig	 *
+ * * * * * * * * * * * * * * * * * * * * */
+
+/**
+ *
+ * Stress test of the ring queue. For every capacity, several producers
+ * push numbered items into one queue while several consumers pop them
+ * until the queue is closed. Every item must come out exactly once, and
+ * a consumer must see the items of one producer in the order they were
+ * pushed. It prints the throughput of each capacity and exits with 1 if
+ * any item was lost, duplicated or reordered.
+ *
+ *   ./bench-ring-queue [-p productors] [-c consumidors] [-n items] [-r repeticions]
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include "ring-queue.h"
+
+static const int capacities[] = { 1, 2, 8, 1024 };
+#define NCAPACITIES (int) (sizeof(capacities) / sizeof(capacities[0]))
+
+typedef struct Stress_ {
+	RingQueue queue;
+	int numProducers;
+	long numItems;				/* per productor */
+	unsigned char *seen;		/* vegades que ha sortit cada item */
+	int reordered;
+} Stress;
+
+typedef struct Worker_ {
+	Stress *stress;
+	int id;
+	pthread_t thread;
+} Worker;
+
+
+static double now(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+//l'item i del productor p es el numero p * numItems + i + 1 (mai NULL)
+static void *producer(void *arg){
+	Worker *w = (Worker *) arg;
+	Stress *s = w->stress;
+	long i;
+
+	for (i = 0; i < s->numItems; i++)
+		pushRingQueue(&(s->queue), (void *) (w->id * s->numItems + i + 1));
+	return NULL;
+}
+
+
+static void *consumer(void *arg){
+	Worker *w = (Worker *) arg;
+	Stress *s = w->stress;
+	long *last, v;
+	void *item;
+	int p;
+
+	last = malloc(s->numProducers * sizeof(long));
+	if (last == NULL) {
+		printf("insufficient memory (consumer)\n");
+		exit(1);
+	}
+	for (p = 0; p < s->numProducers; p++) last[p] = -1;
+
+	while ((item = popRingQueue(&(s->queue), NULL)) != NULL) {
+		v = (long) item - 1;
+		p = v / s->numItems;
+		if (v <= last[p]) __atomic_store_n(&(s->reordered), 1, __ATOMIC_RELAXED);
+		last[p] = v;
+		__atomic_add_fetch(&(s->seen[v]), 1, __ATOMIC_RELAXED);
+	}
+	free(last);
+	return NULL;
+}
+
+
+/**
+ *
+ * Runs the producers and the consumers once over a queue of the given
+ * capacity. Returns the number of wrong items (lost or duplicated, plus
+ * one if some consumer saw them out of order) and the time in *secs.
+ *
+ */
+static long runStress(Stress *s, int capacity, Worker *producers, Worker *consumers, int numConsumers, double *secs){
+	long i, total, lost = 0, duplicated = 0;
+	double t0;
+	int k;
+
+	total = s->numProducers * s->numItems;
+	for (i = 0; i < total; i++) s->seen[i] = 0;
+	s->reordered = 0;
+	initRingQueue(&(s->queue), capacity);
+
+	t0 = now();
+	for (k = 0; k < numConsumers; k++)
+		if (pthread_create(&(consumers[k].thread), NULL, consumer, &consumers[k]) != 0) {
+			printf("No s'ha pogut crear el fil consumidor\n");
+			exit(1);
+		}
+	for (k = 0; k < s->numProducers; k++)
+		if (pthread_create(&(producers[k].thread), NULL, producer, &producers[k]) != 0) {
+			printf("No s'ha pogut crear el fil productor\n");
+			exit(1);
+		}
+	for (k = 0; k < s->numProducers; k++) pthread_join(producers[k].thread, NULL);
+	closeRingQueue(&(s->queue));
+	for (k = 0; k < numConsumers; k++) pthread_join(consumers[k].thread, NULL);
+	*secs = now() - t0;
+
+	deleteRingQueue(&(s->queue));
+
+	for (i = 0; i < total; i++) {
+		if (s->seen[i] == 0) lost++;
+		else if (s->seen[i] > 1) duplicated++;
+	}
+	if (lost || duplicated || s->reordered)
+		printf("  capacitat %d: %ld perduts, %ld duplicats%s\n", capacity, lost, duplicated,
+				s->reordered ? ", desordenats" : "");
+	return lost + duplicated + s->reordered;
+}
+
+
+int main(int argc, char **argv){
+	Worker *producers, *consumers;
+	int opt, c, r, k, numConsumers = 4, numRepeat = 3, failed = 0;
+	double secs, best;
+	Stress s;
+
+	s.numProducers = 4;
+	s.numItems = 200000;
+	while ((opt = getopt(argc, argv, "p:c:n:r:")) != -1) {
+		switch (opt) {
+		case 'p': s.numProducers = atoi(optarg); break;
+		case 'c': numConsumers = atoi(optarg); break;
+		case 'n': s.numItems = atol(optarg); break;
+		case 'r': numRepeat = atoi(optarg); break;
+		default:
+			printf("Us: %s [-p productors] [-c consumidors] [-n items] [-r repeticions]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (s.numProducers < 1 || numConsumers < 1 || s.numItems < 1 || numRepeat < 1) {
+		printf("Els parametres han de ser positius\n");
+		return 1;
+	}
+
+	s.seen = malloc(s.numProducers * s.numItems);
+	producers = malloc(s.numProducers * sizeof(Worker));
+	consumers = malloc(numConsumers * sizeof(Worker));
+	if (s.seen == NULL || producers == NULL || consumers == NULL) {
+		printf("insufficient memory (main)\n");
+		exit(1);
+	}
+	for (k = 0; k < s.numProducers; k++) {
+		producers[k].stress = &s;
+		producers[k].id = k;
+	}
+	for (k = 0; k < numConsumers; k++) {
+		consumers[k].stress = &s;
+		consumers[k].id = k;
+	}
+
+	printf("%d productors, %d consumidors, %ld items per productor, %d repeticions\n",
+			s.numProducers, numConsumers, s.numItems, numRepeat);
+	printf("%10s %14s\n", "capacitat", "Mitems/s");
+	for (c = 0; c < NCAPACITIES; c++) {
+		best = 0;
+		for (r = 0; r < numRepeat; r++) {
+			if (runStress(&s, capacities[c], producers, consumers, numConsumers, &secs) != 0) failed = 1;
+			if (best == 0 || secs < best) best = secs;
+		}
+		printf("%10d %14.2f\n", capacities[c], s.numProducers * s.numItems / best * 1e-6);
+	}
+
+	free(s.seen);
+	free(producers);
+	free(consumers);
+	if (failed) {
+		printf("ERROR: la cua ha perdut o duplicat items\n");
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,116 @@
+/* * * * * * * * * * * * * * * * * * * * *
+ *			[SO2] - PRACTICA 4			 *
+ * +-----------------------------------+ *
+ *	authors: Igor Dzinka / Vicent Roig	 *
+ * * * * * * * * * * * * * * * * * * * * */
+
+/**
+ *
+ * Benchmark of the tokenizer kernels. Every file given in the command
+ * line is read once into memory and then tokenized several times with
+ * each kernel. It prints the throughput of each kernel and checks that
+ * all of them find the same words. The time includes the insertions in
+ * the hash table, but not its allocation. At the end it shows how the
+ * hash table of the biggest file is occupied.
+ *
+ *   ./bench-tokenizer ../database/files/slman10.txt ...
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "tokenizer.h"
+
+#define NREPEAT 20			// nombre de repeticions per nucli
+
+static const TokenizerKernel kernels[] = { TOKENIZER_CTYPE, TOKENIZER_SCALAR, TOKENIZER_SSE2, TOKENIZER_AVX2 };
+#define NKERNELS (int) (sizeof(kernels) / sizeof(kernels[0]))
+
+
+static double now(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+/**
+ *
+ * Counts the distinct words and the total number of words of a table.
+ *
+ */
+static void countWords(HashTable *hashTable, long *distinct, long *total){
+	int i;
+
+	for (i = 0; i < hashTable->size; i++) {
+		if (hashTable->entries[i].primary_key == NULL) continue;
+		(*distinct)++;
+		*total += hashTable->entries[i].numTimes;
+	}
+}
+
+
+int main(int argc, char **argv){
+	MappedFile *files;
+	HashTable *hashTable;
+	long distinct, total, refDistinct = -1, refTotal = -1;
+	double t, start, bytes = 0, ref = 0;
+	int i, k, rep, nfiles = argc - 1, rc = 0;
+
+	if (nfiles < 1) {
+		printf("Us: %s fitxer [fitxer ...]\n", argv[0]);
+		return 1;
+	}
+
+	files = malloc(sizeof(MappedFile) * nfiles);
+	for (i = 0; i < nfiles; i++) {
+		if (mapFile(argv[i + 1], &files[i]) != 0) {
+			printf("No s'ha pogut obrir el fitxer '%s'\n", argv[i + 1]);
+			return 1;
+		}
+		bytes += files[i].size;
+	}
+
+	printf("kernel\tMB/s\tspeedup\tdistinct\twords\n");
+	for (k = 0; k < NKERNELS; k++) {
+		if (setTokenizerKernel(kernels[k]) != 0) continue;	//no suportat per la cpu
+
+		distinct = total = 0;
+		t = 0;
+		for (rep = 0; rep < NREPEAT; rep++) {
+			for (i = 0; i < nfiles; i++) {
+				hashTable = allocHashTable(HASHSIZE);
+				start = now();
+				findWords(files[i].data, files[i].size, hashTable);
+				t += now() - start;		//nomes comptem el temps de tokenitzar
+				if (rep == 0) countWords(hashTable, &distinct, &total);
+				freeHashTable(hashTable);
+			}
+		}
+		if (k == 0) ref = t;
+
+		printf("%s\t%.1f\t%.2f\t%ld\t%ld\n", getTokenizerKernelName(),
+				bytes * NREPEAT / t / 1e6, ref / t, distinct, total);
+
+		if (refDistinct < 0) {
+			refDistinct = distinct;
+			refTotal = total;
+		} else if (distinct != refDistinct || total != refTotal) {
+			printf("ERROR: el nucli %s no troba les mateixes paraules\n", getTokenizerKernelName());
+			rc = 2;
+		}
+	}
+
+	// ocupacio de la taula hash del fitxer mes gran
+	for (i = k = 0; i < nfiles; i++) if (files[i].size > files[k].size) k = i;
+	hashTable = allocHashTable(HASHSIZE);
+	findWords(files[k].data, files[k].size, hashTable);
+	printf("\n%s\n", argv[k + 1]);
+	reportHashTable(hashTable, stdout);
+	freeHashTable(hashTable);
+
+	for (i = 0; i < nfiles; i++) unmapFile(&files[i]);
+	free(files);
+	return rc;
+}
@@ -0,0 +1,832 @@
+/**
+ *
+ * Index builder implementation.
+ *
+ * The ways of building the index from the files of a database: with a
+ * static split of the files among the threads (as in src0), with a shared
+ * counter of files (as in src1), with producers and consumers (the default
+ * of the menu) and with the tree of merges (option -r).
+ *
+ * Igor Dzinka / Vicent Roig, 2014.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+/**
+ * We include the builder.h header. Note the double
+ * quotes.
+ */
+#include "builder.h"
+#include "tokenizer.h"
+#include "scheduler.h"
+#include "ring-queue.h"
+#include "phase.h"
+
+#define MAX_LINECHR 200		// long. maxima per buffer de linia
+#define MAXCHAR 100			// long. maxima per el path del fitxer
+#define NCONSUMERS 2		// nombre de fils consumidors, fan el merge a l'index en paral·lel
+#define REDUCE_MAXLEVELS 32	// nivells de l'arbre de merges (mode reduccio)
+
+static int buildThreads = 0;	// fils demanats amb setBuildThreads, 0: un per processador
+static int buildVerbose = 1;	// 1 per escriure el progres de cada fitxer
+
+static LockSite siteFilelist = LOCK_SITE("lockFilelist");
+static LockSite siteRuns = LOCK_SITE("lockRuns");
+static LockSite siteBarrier = LOCK_SITE("barrierReduce");
+static LockSite siteQueueFull = LOCK_SITE("cua plena (productors)");
+static LockSite siteQueueEmpty = LOCK_SITE("cua buida (consumidors)");
+
+/*
+ * Estat d'una construccio. Tots els fils de la construccio el reben amb els
+ * seus arguments, de manera que dues construccions poden anar alhora.
+ */
+struct build_state{
+	int* nfiles;
+	char** fileList;
+	Index* index;
+	int firstFile;			//fileId del primer fitxer de la llista
+	int numThreads;			//fils productors (o de reduccio)
+	Scheduler sched;		//fitxers pendents de cada fil
+	RingQueue queue;		//fitxers processats, dels productors als consumidors
+
+	pthread_mutex_t lockFilelist;
+	int indexFile;			//seguent fitxer de la llista (estrategia dinamica)
+
+	pthread_mutex_t lockRuns;
+	pthread_barrier_t barrierReduce;
+	pthread_cond_t condStart;	//els fils de reduccio esperen que s'hagin creat tots
+	int start;				//0 esperant, 1 endavant, -1 no s'han pogut crear tots
+	WordRun** runs;			//runs pendents de merge, per nivells
+	int levelStart[REDUCE_MAXLEVELS + 1];
+	WordRun* finalRun;		//run amb tots els fitxers
+};
+
+//arguments de tots els fils: la construccio i el numero del fil
+struct arg_struct_worker{
+	struct build_state* build;
+	int worker;		//cua del planificador d'aquest fil, i shards que omple (reduccio)
+};
+
+//fitxer processat, el que passa per la cua dels productors als consumidors
+struct parsed_file{
+	HashTable* hashTable;
+	int idFile;		//posicio dins de la llista de fitxers
+};
+
+
+
+//prototips
+static Index* createIndexWorkers(char** fileList, int* nfiles, void* (*fn)(void*));
+static void consume(Index *index, HashTable *hashTable, int idFile);
+static void* thread_p(void* arg);
+static void* thread_c(void* arg);
+static void* thread_r(void* arg);
+static void* thread_s(void* arg);
+static void* thread_d(void* arg);
+static void reduceRun(struct build_state* build, WordRun* run, int level, int i);
+
+
+/**
+ *
+ * Initialize the state of a build of the files of fileList into index,
+ * with the number of threads set by setBuildThreads.
+ *
+ */
+static void initBuildState(struct build_state* build, char** fileList, int* nfiles, Index* index, int firstFile){
+	memset(build, 0, sizeof(struct build_state));
+	build->nfiles = nfiles;
+	build->fileList = fileList;
+	build->index = index;
+	build->firstFile = firstFile;
+	build->numThreads = getBuildThreads();
+	pthread_mutex_init(&(build->lockFilelist), NULL);
+	pthread_mutex_init(&(build->lockRuns), NULL);
+	pthread_cond_init(&(build->condStart), NULL);
+}
+
+
+static void deleteBuildState(struct build_state* build){
+	pthread_mutex_destroy(&(build->lockFilelist));
+	pthread_mutex_destroy(&(build->lockRuns));
+	pthread_cond_destroy(&(build->condStart));
+}
+
+
+/**
+ *
+ * Sets the number of threads of the next builds; 0 (the default) means
+ * one per processor. The producer/consumer build adds NCONSUMERS.
+ *
+ */
+void setBuildThreads(int threads){
+	buildThreads = threads > 0 ? threads : 0;
+}
+
+
+int getBuildThreads(void){
+	return buildThreads > 0 ? buildThreads : getNumProcessors();
+}
+
+
+/**
+ *
+ * With 0 the builds do not print the progress of every file.
+ *
+ */
+void setBuildVerbose(int verbose){
+	buildVerbose = verbose;
+}
+
+
+/**
+ *
+ * Builds the index of the files of fileList with the given strategy.
+ * Returns NULL on error.
+ *
+ */
+Index* buildIndex(BuildStrategy strategy, char** fileList, int* nfiles){
+	switch(strategy){
+		case BUILD_STATIC:		return createIndexWorkers(fileList, nfiles, thread_s);
+		case BUILD_DYNAMIC:		return createIndexWorkers(fileList, nfiles, thread_d);
+		case BUILD_REDUCE:		return createIndexReduce(fileList, nfiles);
+		default:				return createIndex(fileList, nfiles);
+	}
+}
+
+
+Index* createIndex(char** fileList, int* nfiles){
+	Index *index = malloc(sizeof(Index));
+    /* Init index */
+	initIndex(index, *nfiles);
+
+	if (fillIndex(index, fileList, nfiles, 0) != 0) {
+		deleteIndex(index);
+		free(index);
+		return NULL;
+	}
+	return index;
+}
+
+
+/**
+ *
+ * Adds the files of fileList to an index that already has words, for
+ * instance one loaded from disk. The new files get the fileIds that follow
+ * the ones of the index, and only they are processed: the cost depends on
+ * the number of new files, not on the size of the index. Returns 0, or -1
+ * if the threads could not be started: then the index may have only some
+ * of the new files, and should be discarded.
+ *
+ */
+int addFilesToIndex(Index* index, char** fileList, int* nfiles){
+	int firstFile = extendIndex(index, *nfiles);
+
+	return fillIndex(index, fileList, nfiles, firstFile);
+}
+
+
+/**
+ *
+ * Processes the files of fileList with the producers and the consumers and
+ * merges them in the index. The file i of the list gets fileId firstFile+i.
+ *
+ */
+int fillIndex(Index* index, char** fileList, int* nfiles, int firstFile){
+	int i, err, numConsumers = 0, numProducers = 0, rc = 0;
+	pthread_t *tid;
+	struct arg_struct_worker *args;
+	struct build_state build;
+	int numThreads;
+
+	thawIndex(index);	//els arbres canviaran
+
+	initBuildState(&build, fileList, nfiles, index, firstFile);
+	numThreads = build.numThreads;
+
+	if ((tid = (pthread_t*) malloc((numThreads+NCONSUMERS)*sizeof(pthread_t))) == NULL) {
+		deleteBuildState(&build);
+		return -1;
+	}
+	if ((args = malloc((numThreads+NCONSUMERS)*sizeof(struct arg_struct_worker))) == NULL) {
+		free(tid);
+		deleteBuildState(&build);
+		return -1;
+	}
+
+	//els fitxers mes grans primer, repartits entre les cues dels productors
+	if (initScheduler(&(build.sched), fileList, *nfiles, numThreads) != 0) {
+		free(tid);
+		free(args);
+		deleteBuildState(&build);
+		return -1;
+	}
+	//tantes places com productors, com el buffer d'abans
+	initRingQueue(&(build.queue), numThreads);
+
+    //creació dels threads consumidors
+    for(i=0; i < NCONSUMERS; i++){
+    	args[i].build = &build;
+    	args[i].worker = i;
+    	if( (err = pthread_create(&tid[i], NULL, &thread_c, (void *) &args[i])) != 0){
+    		printf("\ncan't create thread :[%s]", strerror(err));
+    		rc = -1;
+    		break;
+    	}
+    	numConsumers++;
+    }
+
+	//creaació dels threads productor
+    for(i=NCONSUMERS; rc == 0 && i < numThreads+NCONSUMERS; i++){
+    	args[i].build = &build;
+    	args[i].worker = i-NCONSUMERS;
+    	if( (err = pthread_create(&tid[i], NULL, &thread_p, (void *) &args[i])) != 0){
+    		printf("\ncan't create thread :[%s]", strerror(err));
+    		rc = -1;
+    		break;
+    	}
+    	numProducers++;
+    }
+
+    /* El fil principal es quedarà esperant que els fils creats finalitzin la creacio de l’arbre.
+     * Si algun fil no s'ha pogut crear s'espera igualment els altres, perque
+     * qui crida pugui alliberar l'index. Els productors que falten no
+     * demanaran fitxers: el planificador no els ha d'esperar */
+    retireScheduledWorkers(&(build.sched), numThreads - numProducers);
+    for(i=NCONSUMERS; i < numProducers+NCONSUMERS; i++){
+    	pthread_join(tid[i], NULL);
+    }
+    //ja no hi haura mes fitxers: els consumidors acaben quan buiden la cua
+    closeRingQueue(&(build.queue));
+    for(i=0; i < numConsumers; i++){
+    	pthread_join(tid[i], NULL);
+    }
+    //els fitxers grans van primer: els fileIds arriben desordenats
+    if (rc == 0) sortIndexPostings(index);
+
+	deleteRingQueue(&(build.queue));
+	deleteScheduler(&(build.sched));
+	deleteBuildState(&build);
+	free(tid);
+	free(args);
+
+    return rc;
+}
+
+
+/**
+ * Funció per llegir el fitxer de configuració i guardar el seu contingut a una llista que es passa per referencia
+ */
+char** readDatabase(char *configFile, int* nfiles){
+	FILE *fp;
+	int i;
+	char *pname;
+	char** fileList = NULL;
+	char line[MAX_LINECHR], path[MAXCHAR], file[MAXCHAR];
+	pname = NULL;
+	
+	fp = fopen(configFile, "r");
+	if (!fp) {
+		printf("No s'ha pogut obrir el fitxer '%s'\n", configFile);
+		return NULL;
+	}
+
+	fgets(line, MAXCHAR, fp);	//llegim la primera linia amb el nombre de arxius a processar
+	*nfiles = atoi(line);		//fent servir funcio atoi com indica el manual de la practica
+	if (buildVerbose) printf("nfiles = %d\n",*nfiles);
+	if ( *nfiles < 1) {
+		printf("El nombre d'arxius al fitxer '%s' no es correcte.\n", configFile);
+		fclose(fp);
+		return NULL;
+	}
+
+	//reservem memoria per a la llista de fitxers
+	if ((fileList = (char**) malloc((*nfiles)*sizeof( char*))) == NULL) return NULL; 
+	
+
+	/* Extract pathname: aixo sera util per poder referenciar .cfg amb paths relatius */
+	pname = strrchr(configFile, '/'); 	//trobem la ultima aparicio del caracter '/' al nom de la base de dades
+	if (pname == NULL)					//si no hi ha cap '/' llavors inicialitzem un string buit
+		path[0] = '\0';
+	else {
+		strcpy(path, configFile);		//copiem la ruta de la base de dades
+		path[pname-configFile+1] = '\0';//treiem a la ruta el nom de la base de dades per quedar-nos nomes amb la ruta a la carpeta on es troba
+	}
+	
+	for(i=0; i < (*nfiles); i++) {
+		// LLegim la linia 
+		fgets(line, MAX_LINECHR, fp);
+		line[strlen(line)-1] = '\0';	//fgets inclou el \n, per tant el substituim per el EOS.
+
+		// Generem la ruta del fitxer a llegir
+		strcpy(file, path);		//copiem la ruta fin a la carpeta (calculada abans)
+		strcat(file, line);		//concatenem el nom  del fitxer i  aixi obtenim la ruta absoluta
+		
+		//reservem tant espai com es requereix per guardar la ruta
+		if ((fileList[i] = malloc( sizeof(char)*(strlen(file)+1) )) == NULL) return NULL;
+
+		//guardem  la ruta a la llista de fitxers
+		strcpy(fileList[i], file);
+		//printf("IT%d -- STRCPY RESULT [%s]->[%s]\n", i, file, fileList[i]);
+	}
+	
+	fclose(fp);	//tanquem el fitxer de base de dades
+	return fileList;
+}
+
+
+//tros d'un fitxer gran, el tokenitza el fil que l'agafa del planificador
+static void findWordsTask(void* arg){
+	WordChunk *chunk = (WordChunk *) arg;
+
+	PHASE_BEGIN(tokenize, "tokenize_chunk", -1);
+	chunk->hashTable = allocHashTable(HASHSIZE);
+	findWords(chunk->buffer, chunk->size, chunk->hashTable);
+	PHASE_END(tokenize, PHASE_TOKENIZE, "tokenize_chunk");
+}
+
+
+/**
+ *
+ * Tokenizes a file of the build into hashTable. A very big file is split
+ * in chunks, up to one per thread: worker does the first one and gives
+ * the others to the scheduler, where the threads without files take them
+ * before their next file. Their tables are merged at the end.
+ *
+ */
+static void tokenizeFile(struct build_state* build, int worker, MappedFile* file, HashTable* hashTable){
+	WordChunk chunks[TOKENIZER_MAXCHUNKS];
+	SchedTask tasks[TOKENIZER_MAXCHUNKS];
+	TaskGroup group;
+	int k, n, numChunks;
+
+	numChunks = file->size / TOKENIZER_CHUNKSIZE;
+	if (build == NULL || build->sched.numWorkers < 2) numChunks = 1;	//sense planificador
+	else if (numChunks > build->numThreads) numChunks = build->numThreads;
+
+	n = splitWordChunks(file->data, file->size, chunks, numChunks);
+	if (n == 1) {
+		findWords(file->data, file->size, hashTable);
+		return;
+	}
+
+	initTaskGroup(&group);
+	for (k = n - 1; k >= 1; k--) {		//el primer tros que es fara es el segon
+		tasks[k].run = findWordsTask;
+		tasks[k].arg = &chunks[k];
+		pushScheduledTask(&(build->sched), worker, &group, &tasks[k]);
+	}
+
+	findWords(chunks[0].buffer, chunks[0].size, hashTable);
+	waitScheduledTasks(&(build->sched), worker, &group);
+	deleteTaskGroup(&group);
+
+	for (k = 1; k < n; k++) mergeHashTable(hashTable, chunks[k].hashTable);
+}
+
+
+/**
+ *
+ * Donat un fitxer extreu d'ell totes les paraules i les guarda a una hashTable
+ * Retorna la hashTable amb les paraules
+ *
+ * El fitxer es llegeix sencer (mmap) i es tokenitza en una sola passada, sense
+ * copiar-lo linia a linia. Dins d'una construccio amb planificador, un fitxer
+ * molt gran es parteix en trossos que tokenitzen els fils lliures.
+ *
+ */
+static HashTable* processBuildFile(struct build_state* build, int worker, char* filename){
+	
+	HashTable *hashTable;
+	MappedFile file;
+
+	PHASE_BEGIN(read, "read", -1);
+	if (mapFile(filename, &file) != 0) {
+		TRACE_END("read");
+		printf("\nNo s'ha pogut obrir el fitxer '%s'", filename);
+		return NULL ;
+	}
+	PHASE_END(read, PHASE_READ, "read");
+	METRICS_ADD(METRIC_BYTES, file.size);
+
+	PHASE_BEGIN(tokenize, "tokenize", -1);
+	hashTable = allocHashTable(HASHSIZE);
+	// extreiem mitjançant la funcio findWords totes les paraules del fitxer
+	tokenizeFile(build, worker, &file, hashTable);
+	PHASE_END(tokenize, PHASE_TOKENIZE, "tokenize");
+	METRICS_ADD(METRIC_FILE_WORDS, hashTable->numItems);
+
+	PHASE_BEGIN(unmap, "free", -1);
+	unmapFile(&file);
+	PHASE_END(unmap, PHASE_FREE, "free");
+	return hashTable;
+}
+
+
+/**
+ *
+ * Same as processBuildFile, outside of a build: the file is tokenized by
+ * the calling thread.
+ *
+ */
+HashTable* processFile(char* filename){
+	return processBuildFile(NULL, 0, filename);
+}
+
+
+
+/* * * * * * * * * * * * * * * * * *
+ *   
+ *	Consumer/Producer functions
+ *
+ * * * * * * * * * * * * * * * * * */
+
+static void consume(Index *index, HashTable *hashTable, int idFile){
+	
+	if (hashTable) { 				// si s'ha pogut crear l'estructura local, copiem el seu contingut a l'estructura global
+		PHASE_BEGIN(merge, "merge", idFile);
+		copyHashTableToIndex(hashTable, index, idFile);	//copiant el contingut a l'index
+		PHASE_END(merge, PHASE_MERGE, "merge");
+		if (buildVerbose) printf("\n\t\t[thread] > Fitxer %d copiat a l'index", idFile);
+
+		PHASE_BEGIN(release, "free", idFile);
+		freeHashTable(hashTable);
+		PHASE_END(release, PHASE_FREE, "free");
+	}
+}
+
+
+static void* thread_p(void* arg){
+	struct arg_struct_worker *args = (struct arg_struct_worker *) arg;
+	struct build_state *build = args->build;
+
+	char* filename;
+	int localIndex, sleeps;
+	struct parsed_file* parsed;
+	
+	TRACE_THREAD("producer", args->worker);
+
+	//el planificador dona el seguent fitxer, -1 quan ja no en queden
+	localIndex = nextScheduledFile(&(build->sched), args->worker);
+	
+	while(localIndex >= 0){
+		TRACE_BEGIN("file", localIndex);
+
+		// Process file
+		filename = build->fileList[localIndex];
+		if (buildVerbose) printf("\n\t[thread ] > Entrant a processFile per tractar el fitxer %s", filename);
+		if ((parsed = malloc(sizeof(struct parsed_file))) == NULL) {
+			printf("insufficient memory (thread_p)\n");
+			exit(1);
+		}
+		parsed->hashTable = processBuildFile(build, args->worker, filename);	// processament del fitxer i assignacio de resultats a estructura local
+		parsed->idFile = localIndex;
+
+		PHASE_BEGIN(push, "queue_push", localIndex);
+		sleeps = pushRingQueue(&(build->queue), parsed);	//espera si la cua es plena
+		PHASE_WAIT_END(push, PHASE_QUEUE, sleeps ? &siteQueueFull : NULL, "queue_push");
+		TRACE_END("file");
+
+		localIndex = nextScheduledFile(&(build->sched), args->worker);
+	}
+	return NULL;
+}
+
+
+/*
+ * Hi ha NCONSUMERS consumidors. Cadascun agafa una taula de la cua i en fa
+ * el merge a l'index, de manera que diversos fitxers es poden copiar alhora
+ * (cada shard de l'index te el seu propi lock). Acaben quan la cua es
+ * tancada i buida.
+ */
+static void* thread_c(void* arg){
+	struct arg_struct_worker *args = (struct arg_struct_worker *) arg;
+	struct build_state *build = args->build;
+	struct parsed_file* parsed;
+	int sleeps;
+
+	TRACE_THREAD("consumer", -1);
+
+	while(1){
+		PHASE_BEGIN(pop, "queue_pop", -1);
+		parsed = popRingQueue(&(build->queue), &sleeps);	//espera si la cua es buida
+		PHASE_WAIT_END(pop, PHASE_QUEUE, sleeps ? &siteQueueEmpty : NULL, "queue_pop");
+		if(parsed == NULL) break;
+
+		consume(build->index, parsed->hashTable, build->firstFile + parsed->idFile);
+		free(parsed);
+	}
+	return NULL;
+}
+
+
+/* * * * * * * * * * * * * * * * * *
+ *   
+ *	Tree of merges (-r)
+ *
+ * * * * * * * * * * * * * * * * * */
+
+/**
+ *
+ * Builds the index with a tree of merges instead of the buffer. Every thread
+ * takes files from the list, turns each one into a sorted run and merges it
+ * with its neighbour: file 2i with 2i+1 at level 0, then the results in pairs
+ * at level 1, and so on. The thread that finishes the second half of a pair
+ * does the merge, so the merges are spread among all the threads and the
+ * depth is log2(nfiles). At the end the run of the whole database is loaded
+ * in the index, each thread filling a part of the shards. Returns NULL if
+ * the threads could not be created.
+ *
+ */
+Index* createIndexReduce(char** fileList, int* nfiles){
+	struct arg_struct_worker *args;
+	struct build_state build;
+	pthread_t *tid;
+	Index *index;
+	int i, err, level, numLevel, numThreads, numCreated;
+
+	initBuildState(&build, fileList, nfiles, NULL, 0);
+	numThreads = build.numThreads;
+	args = malloc(numThreads*sizeof(struct arg_struct_worker));
+	tid = malloc(numThreads*sizeof(pthread_t));
+	if (args == NULL || tid == NULL) {
+		free(args);
+		free(tid);
+		deleteBuildState(&build);
+		return NULL;
+	}
+
+	//posicio de cada nivell dins de runs: el nivell l te ceil(nfiles / 2^l) runs
+	build.levelStart[0] = 0;
+	for(level = 0; level < REDUCE_MAXLEVELS; level++){
+		numLevel = ((*nfiles - 1) >> level) + 1;
+		build.levelStart[level+1] = build.levelStart[level] + numLevel;
+	}
+	if ((build.runs = (WordRun**) calloc(build.levelStart[REDUCE_MAXLEVELS], sizeof(WordRun*))) == NULL) {
+		free(args);
+		free(tid);
+		deleteBuildState(&build);
+		return NULL;
+	}
+
+	index = malloc(sizeof(Index));
+	initIndex(index, *nfiles);
+	build.index = index;
+	build.finalRun = NULL;
+
+	if (initScheduler(&(build.sched), fileList, *nfiles, numThreads) != 0) {
+		deleteIndex(index);
+		free(index);
+		free(build.runs);
+		free(args);
+		free(tid);
+		deleteBuildState(&build);
+		return NULL;
+	}
+	pthread_barrier_init(&(build.barrierReduce), NULL, numThreads);
+
+	//els fils esperen a la sortida fins que s'han creat tots: amb algun de
+	//menys la barrera no s'obriria mai
+	for(i=0; i < numThreads; i++){
+		args[i].build = &build;
+		args[i].worker = i;
+		if( (err = pthread_create(&tid[i], NULL, &thread_r, (void *) &args[i])) != 0){
+			printf("\ncan't create thread :[%s]\n", strerror(err));
+			break;
+		}
+	}
+	numCreated = i;
+
+	pthread_mutex_lock(&(build.lockRuns));
+	build.start = numCreated == numThreads ? 1 : -1;
+	pthread_cond_broadcast(&(build.condStart));
+	pthread_mutex_unlock(&(build.lockRuns));
+
+	for(i=0; i < numCreated; i++){
+		pthread_join(tid[i], NULL);
+	}
+
+	deleteScheduler(&(build.sched));
+	pthread_barrier_destroy(&(build.barrierReduce));
+	if(build.finalRun) freeWordRun(build.finalRun);
+	free(build.runs);
+	deleteBuildState(&build);
+	free(args);
+	free(tid);
+
+	if (numCreated < numThreads) {	//cap fil ha fet res
+		deleteIndex(index);
+		free(index);
+		return NULL;
+	}
+	return index;
+}
+
+
+/**
+ *
+ * Puts the run of node i of the given level in the tree of merges. If its
+ * pair is already there, both are merged and the result goes one level up;
+ * otherwise the run waits for the thread that finishes the pair.
+ *
+ */
+static void reduceRun(struct build_state* build, WordRun* run, int level, int i){
+	WordRun** runs = build->runs;
+	int* levelStart = build->levelStart;
+	WordRun* other;
+	int numLevel;
+	uint64_t since;
+
+	while(1){
+		numLevel = levelStart[level+1] - levelStart[level];
+		if(numLevel == 1){		//arrel: ja tenim tots els fitxers
+			build->finalRun = run;
+			return;
+		}
+
+		if((i ^ 1) < numLevel){
+			PHASE_LOCK_MUTEX(lock, &(build->lockRuns), &siteRuns, -1, 0, since);
+			other = runs[levelStart[level] + (i ^ 1)];
+			if(other == NULL){	//la parella encara no hi es, ja fara el merge qui l'acabi
+				runs[levelStart[level] + i] = run;
+				PROFILE_UNLOCK(&(build->lockRuns), &siteRuns, since);
+				return;
+			}
+			runs[levelStart[level] + (i ^ 1)] = NULL;
+			PROFILE_UNLOCK(&(build->lockRuns), &siteRuns, since);
+
+			//els fitxers del run parell van sempre abans que els del senar
+			PHASE_BEGIN(merge, "merge_runs", -1);
+			if(i & 1) run = mergeWordRuns(other, run);
+			else run = mergeWordRuns(run, other);
+			PHASE_END(merge, PHASE_MERGE, "merge_runs");
+		}
+		//sense parella (ultim d'un nivell senar) el run puja tal qual
+
+		level++;
+		i >>= 1;
+	}
+}
+
+
+static void* thread_r(void* arg){
+	struct arg_struct_worker *args = (struct arg_struct_worker *) arg;
+	struct build_state *build = args->build;
+	HashTable* hashTable;
+	WordRun* run;
+	int localIndex;
+
+	TRACE_THREAD("reduce", args->worker);
+
+	pthread_mutex_lock(&(build->lockRuns));
+	while(build->start == 0) pthread_cond_wait(&(build->condStart), &(build->lockRuns));
+	pthread_mutex_unlock(&(build->lockRuns));
+	if(build->start < 0) return NULL;
+
+	while(1){
+		localIndex = nextScheduledFile(&(build->sched), args->worker);
+		if(localIndex < 0) break;
+		TRACE_BEGIN("file", localIndex);
+
+		if (buildVerbose) printf("\n\t[thread ] > Entrant a processFile per tractar el fitxer %s", build->fileList[localIndex]);
+		hashTable = processBuildFile(build, args->worker, build->fileList[localIndex]);
+
+		PHASE_BEGIN(sort, "sort", localIndex);
+		run = allocWordRun(hashTable, localIndex);
+		PHASE_END(sort, PHASE_MERGE, "sort");
+
+		PHASE_BEGIN(release, "free", localIndex);
+		if(hashTable) freeHashTable(hashTable);
+		PHASE_END(release, PHASE_FREE, "free");
+
+		reduceRun(build, run, 0, localIndex);
+		TRACE_END("file");
+	}
+
+	//quan tots els fils arriben aqui l'arbre de merges ha acabat
+	PHASE_BEGIN(barrier, "barrier", -1);
+	pthread_barrier_wait(&(build->barrierReduce));
+	PHASE_WAIT_END(barrier, PHASE_BARRIER, &siteBarrier, "barrier");
+
+	PHASE_BEGIN(merge, "fill_shards", -1);
+	copyWordRunToIndex(build->finalRun, build->index, args->worker, build->numThreads);
+	PHASE_END(merge, PHASE_MERGE, "fill_shards");
+
+	return NULL;
+}
+
+
+/* * * * * * * * * * * * * * * * * *
+ *   
+ *	Static and dynamic split (src0, src1)
+ *
+ * * * * * * * * * * * * * * * * * */
+
+/**
+ *
+ * Builds the index with numThreads threads that run fn. Every thread
+ * processes its files and merges each one in the index itself.
+ *
+ */
+static Index* createIndexWorkers(char** fileList, int* nfiles, void* (*fn)(void*)){
+	struct arg_struct_worker *args;
+	struct build_state build;
+	pthread_t *tid;
+	Index *index;
+	int i, err, numCreated, numThreads;
+
+	initBuildState(&build, fileList, nfiles, NULL, 0);
+	numThreads = build.numThreads;
+	args = malloc(numThreads*sizeof(struct arg_struct_worker));
+	tid = malloc(numThreads*sizeof(pthread_t));
+	if (args == NULL || tid == NULL) {
+		free(args);
+		free(tid);
+		deleteBuildState(&build);
+		return NULL;
+	}
+
+	index = malloc(sizeof(Index));
+	initIndex(index, *nfiles);
+	build.index = index;
+	build.indexFile = 0;
+
+	for(i=0; i < numThreads; i++){
+		args[i].build = &build;
+		args[i].worker = i;
+		if( (err = pthread_create(&tid[i], NULL, fn, (void *) &args[i])) != 0){
+			printf("\ncan't create thread :[%s]", strerror(err));
+			break;
+		}
+	}
+	numCreated = i;
+
+	for(i=0; i < numCreated; i++){
+		pthread_join(tid[i], NULL);
+	}
+	if (numCreated == numThreads) sortIndexPostings(index);
+
+	deleteBuildState(&build);
+	free(args);
+	free(tid);
+	if (numCreated < numThreads) {	//els fils creats ja han acabat: es pot alliberar
+		deleteIndex(index);
+		free(index);
+		return NULL;
+	}
+	return index;
+}
+
+
+/*
+ * Repartiment estatic: el fil i fa el tros i de la llista, i l'ultim tambe
+ * els fitxers que sobren.
+ */
+static void* thread_s(void* arg){
+	struct arg_struct_worker *args = (struct arg_struct_worker *) arg;
+	struct build_state *build = args->build;
+	int i, chunk = *build->nfiles / build->numThreads;
+	int start = chunk * args->worker;
+	int end = (args->worker == build->numThreads-1) ? *build->nfiles : start + chunk;
+
+	TRACE_THREAD("worker", args->worker);
+
+	for(i = start; i < end; i++){
+		TRACE_BEGIN("file", i);
+		if (buildVerbose) printf("\n\t[thread ] > Entrant a processFile per tractar el fitxer %s", build->fileList[i]);
+		consume(build->index, processFile(build->fileList[i]), i);
+		TRACE_END("file");
+	}
+	return NULL;
+}
+
+
+/*
+ * Repartiment dinamic: cada fil agafa el seguent fitxer de la llista amb
+ * el lock lockFilelist.
+ */
+static void* thread_d(void* arg){
+	struct arg_struct_worker *args = (struct arg_struct_worker *) arg;
+	struct build_state *build = args->build;
+	int localIndex;
+	uint64_t since;
+
+	TRACE_THREAD("worker", args->worker);
+
+	while(1){
+		PHASE_LOCK_MUTEX(lock, &(build->lockFilelist), &siteFilelist, -1, 0, since);
+		localIndex = build->indexFile++;
+		PROFILE_UNLOCK(&(build->lockFilelist), &siteFilelist, since);
+
+		if(localIndex >= *build->nfiles) break;
+
+		TRACE_BEGIN("file", localIndex);
+		if (buildVerbose) printf("\n\t[thread ] > Entrant a processFile per tractar el fitxer %s", build->fileList[localIndex]);
+		consume(build->index, processFile(build->fileList[localIndex]), localIndex);
+		TRACE_END("file");
+	}
+	return NULL;
+}
@@ -0,0 +1,52 @@
+/**
+ *
+ * Index builder header
+ *
+ * Include this file in order to be able to call the
+ * functions available in builder.c. We include
+ * here only those information we want to make visible
+ * to other files.
+ *
+ * Igor Dzinka / Vicent Roig, 2014.
+ *
+ */
+#ifndef BUILDER_H
+#define BUILDER_H
+
+#include "index.h"
+
+/**
+ *
+ * Ways of splitting the work of building the index among the threads:
+ *
+ *  BUILD_STATIC    each thread gets a fixed range of the file list (src0)
+ *  BUILD_DYNAMIC   the threads take the next file of the list (src1)
+ *  BUILD_PIPELINE  producers tokenize, consumers merge (menu option 1)
+ *  BUILD_REDUCE    tree of merges of sorted runs (menu option 1 with -r)
+ *
+ */
+typedef enum {
+	BUILD_STATIC,
+	BUILD_DYNAMIC,
+	BUILD_PIPELINE,
+	BUILD_REDUCE
+} BuildStrategy;
+
+/**
+ *
+ * Function heders we want to make visible so that they
+ * can be called from any other file.
+ *
+ */
+void setBuildThreads(int threads);
+int getBuildThreads(void);
+void setBuildVerbose(int verbose);
+char** readDatabase(char *configFile, int* nfiles);
+HashTable* processFile(char* filename);
+Index* buildIndex(BuildStrategy strategy, char** fileList, int* nfiles);
+Index* createIndex(char** fileList, int* nfiles);
+Index* createIndexReduce(char** fileList, int* nfiles);
+int addFilesToIndex(Index* index, char** fileList, int* nfiles);
+int fillIndex(Index* index, char** fileList, int* nfiles, int firstFile);
+
+#endif
@@ -0,0 +1,119 @@
+/**
+ *
+ * Eytzinger array implementation.
+ *
+ * Lookups without pointers: the position of the next entry to compare
+ * is computed, and the cache lines of four levels below are requested
+ * in advance. A search reads about log2(n) / 2 cache lines instead of
+ * one Node, one RBData and one key per level of the tree.
+ *
+ * Igor Dzinka / Vicent Roig, 2014.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * We include the eytzinger.h header. Note the double
+ * quotes.
+ */
+#include "eytzinger.h"
+
+#define EYTZINGER_ALIGN 64		// tamany de la linia de cache
+#define EYTZINGER_PREFETCH 16	// 4 nivells per sota: 16 entrades = 4 linies de cache
+
+
+/**
+ *
+ * First 8 bytes of the key as a big endian integer, padded with zeros.
+ * Comparing two prefixes gives the same order as strcmp on the first 8
+ * bytes.
+ *
+ */
+static uint64_t keyPrefix(const char *key){
+	uint64_t prefix = 0;
+	int i;
+
+	for (i = 0; i < 8 && key[i]; i++) prefix |= (uint64_t) (unsigned char) key[i] << (56 - 8 * i);
+	return prefix;
+}
+
+
+/**
+ *
+ * Fills the positions of the subtree of k with the nodes of the tree in
+ * order: the left subtree, k and the right subtree.
+ *
+ */
+static Node *fillRecursive(Eytzinger *eytzinger, Node *node, int k){
+	if (k > eytzinger->numEntries) return node;
+
+	node = fillRecursive(eytzinger, node, 2 * k);
+	eytzinger->entries[k].prefix = keyPrefix(node->data->primary_key);
+	eytzinger->entries[k].data = node->data;
+	node = nextNode(node);
+
+	return fillRecursive(eytzinger, node, 2 * k + 1);
+}
+
+
+/**
+ *
+ * Builds the array from the words of the tree. Position 0 is not used
+ * and is placed at the start of a cache line: then the root and its two
+ * children share a line, and the 16 entries four levels below any
+ * position fill 4 whole lines.
+ *
+ */
+void buildEytzinger(Eytzinger *eytzinger, RBTree *tree){
+	void *entries;
+
+	eytzinger->numEntries = tree->numNodes;
+	if (posix_memalign(&entries, EYTZINGER_ALIGN, sizeof(EytzingerEntry) * (tree->numNodes + 1)) != 0) {
+		printf("insufficient memory (buildEytzinger)\n");
+		exit(1);
+	}
+	eytzinger->entries = entries;
+
+	fillRecursive(eytzinger, firstNode(tree), 1);
+}
+
+
+/**
+ *
+ * Finds the data of a word, NULL if it is not in the array. The loop
+ * goes down to the bottom without branches on the result of the
+ * comparisons; the position of the lower bound is recovered at the end
+ * from the bits of k.
+ *
+ */
+RBData *findEytzinger(Eytzinger *eytzinger, const char *primary_key){
+	const EytzingerEntry *entries = eytzinger->entries;
+	uint64_t prefix = keyPrefix(primary_key);
+	int k = 1, n = eytzinger->numEntries, less;
+
+	while (k <= n) {
+		__builtin_prefetch(entries + (long) EYTZINGER_PREFETCH * k);
+		if (entries[k].prefix != prefix) less = entries[k].prefix < prefix;
+		else less = strcmp(entries[k].data->primary_key, primary_key) < 0;
+		k = 2 * k + less;
+	}
+	k >>= __builtin_ffs(~k);	//treiem els girs a la dreta finals
+
+	if (k == 0 || entries[k].prefix != prefix || strcmp(entries[k].data->primary_key, primary_key) != 0) return NULL;
+	return entries[k].data;
+}
+
+
+/**
+ *
+ * Frees the array. The data belong to the tree and are not freed.
+ *
+ */
+void freeEytzinger(Eytzinger *eytzinger){
+	free(eytzinger->entries);
+	eytzinger->entries = NULL;
+	eytzinger->numEntries = 0;
+}
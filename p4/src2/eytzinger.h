@@ -0,0 +1,48 @@
+/**
+ *
+ * Eytzinger array header
+ *
+ * Include this file in order to be able to call the
+ * functions available in eytzinger.c. We include
+ * here only those information we want to make visible
+ * to other files.
+ *
+ * Igor Dzinka / Vicent Roig, 2014.
+ *
+ */
+#ifndef EYTZINGER_H
+#define EYTZINGER_H
+
+#include "red-black-tree.h"
+
+/**
+ *
+ * Read-only copy of a red-black tree for lookups. The words are stored in
+ * a sorted array in Eytzinger (breadth first) order: the children of
+ * position k are 2k and 2k+1, so the first levels share a few cache lines
+ * and the next ones can be prefetched. Each entry holds the first 8 bytes
+ * of the word as an integer, so most comparisons do not read the word.
+ * The data are the ones of the tree, which has to be kept.
+ *
+ */
+typedef struct EytzingerEntry_ {
+	uint64_t prefix;		/* primers 8 bytes de la paraula, big endian */
+	RBData *data;
+} EytzingerEntry;
+
+typedef struct Eytzinger_ {
+	EytzingerEntry *entries;	/* posicions 1..numEntries */
+	int numEntries;
+} Eytzinger;
+
+/**
+ *
+ * Function heders we want to make visible so that they
+ * can be called from any other file.
+ *
+ */
+void buildEytzinger(Eytzinger *eytzinger, RBTree *tree);
+RBData *findEytzinger(Eytzinger *eytzinger, const char *primary_key);
+void freeEytzinger(Eytzinger *eytzinger);
+
+#endif
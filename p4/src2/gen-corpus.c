@@ -0,0 +1,326 @@
+/* * * * * * * * * * * * * * * * * * * * *
+ *			[SO2] - PRACTICA 4			 *
+ * +-----------------------------------+ *
+ *	authors: Igor Dzinka / Vicent Roig	 *
+ * * * * * * * * * * * * * * * * * * * * */
+
+/**
+ *
+ * Generator of synthetic databases for the benchmarks. It writes numFiles
+ * text files with words taken from a vocabulary with a Zipf distribution
+ * (the word of rank r appears with probability proportional to 1/r^z),
+ * in sentences and lines like the ones of the books of ../database, and
+ * the .cfg that lists them in the format of readDatabase. The output only
+ * depends on the options: file i is written with its own generator,
+ * seeded from the seed and i.
+ *
+ *   ./gen-corpus [-n fitxers] [-s bytes | -t bytes] [-d fixed|uniform|pareto]
+ *                [-v vocabulari] [-z exponent] [-S llavor] directori
+ *
+ * creates directori/llista.cfg and directori/files/gen*.txt. -s gives the
+ * mean size of a file and -t the size of the whole database: the sizes
+ * drawn are scaled so that they add up to it.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+#define MAXFILES 100000		// fitxers com a molt
+#define MAXVOCABULARY 10000000	// paraules diferents com a molt
+#define MAXCHAR 100			// long. maxima d'un path, com a readDatabase
+#define LINE_WIDTH 72		// les linies es tallen en arribar a aquesta amplada
+#define PARETO_ALPHA 1.5	// forma de la distribucio de tamanys pareto
+#define PARETO_MAXFACTOR 100	// cap fitxer pareto passa de 100 vegades la mitjana
+
+typedef enum { SIZE_FIXED, SIZE_UNIFORM, SIZE_PARETO } SizeDistribution;
+
+static const char consonants[] = "bcdfghjklmnprstvwyzq";	// 20
+static const char vowels[] = "aeiou";						// 5
+static const char endings[] = "nrstldmgkp";				// 10
+
+
+/**
+ *
+ * splitmix64: small generator with good statistical quality. The state
+ * is a single integer, so every file can have its own.
+ *
+ */
+static uint64_t nextRandom(uint64_t *state){
+	uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+
+/**
+ *
+ * Uniform real number in [0, 1).
+ *
+ */
+static double nextUniform(uint64_t *state){
+	return (nextRandom(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+
+/**
+ *
+ * Writes the word of rank i (0 is the most frequent). The word is a
+ * sequence of consonant-vowel syllables, the number i/11 written in
+ * bijective base 100, followed by an optional final consonant chosen by
+ * i%11. Every rank gets a different word, and the frequent ones are the
+ * shortest, as in a natural language. Returns the length.
+ *
+ */
+static int makeWord(uint64_t i, char *word){
+	char syllables[32];
+	uint64_t n = i / 11 + 1;
+	int len = 0, k = 0, digit;
+
+	while (n > 0) {
+		digit = (n - 1) % 100;
+		n = (n - 1) / 100;
+		syllables[k++] = digit;
+	}
+	while (k > 0) {
+		digit = syllables[--k];
+		word[len++] = consonants[digit / 5];
+		word[len++] = vowels[digit % 5];
+	}
+	if (i % 11) word[len++] = endings[i % 11 - 1];
+	word[len] = '\0';
+	return len;
+}
+
+
+/**
+ *
+ * Cumulative distribution of the ranks: cdf[r] is the probability of a
+ * rank <= r. A rank is drawn with a binary search of a uniform number.
+ *
+ */
+static double *buildZipf(int vocabulary, double exponent){
+	double *cdf = malloc(sizeof(double) * vocabulary), sum = 0;
+	int r;
+
+	if (cdf == NULL) {
+		printf("insufficient memory (buildZipf)\n");
+		exit(1);
+	}
+	for (r = 0; r < vocabulary; r++) {
+		sum += 1.0 / pow(r + 1, exponent);
+		cdf[r] = sum;
+	}
+	for (r = 0; r < vocabulary; r++) cdf[r] /= sum;
+	return cdf;
+}
+
+
+static int drawRank(const double *cdf, int vocabulary, uint64_t *state){
+	double u = nextUniform(state);
+	int lo = 0, hi = vocabulary - 1, mid;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (cdf[mid] < u) lo = mid + 1;
+		else hi = mid;
+	}
+	return lo;
+}
+
+
+/**
+ *
+ * Size in bytes of one file, with the given mean. The pareto sizes have a
+ * few files much bigger than the others, up to PARETO_MAXFACTOR times the
+ * mean: without the bound, one draw of u near 0 gives a file of gigabytes.
+ *
+ */
+static long drawSize(SizeDistribution dist, long mean, uint64_t *state){
+	double u, size;
+
+	switch (dist) {
+		case SIZE_UNIFORM:
+			return (long) (mean * (0.5 + nextUniform(state)));
+		case SIZE_PARETO:
+			u = 1.0 - nextUniform(state);
+			size = mean * (PARETO_ALPHA - 1) / PARETO_ALPHA / pow(u, 1.0 / PARETO_ALPHA);
+			if (size > (double) mean * PARETO_MAXFACTOR) size = (double) mean * PARETO_MAXFACTOR;
+			return (long) size;
+		default:
+			return mean;
+	}
+}
+
+
+/**
+ *
+ * Writes a file of about size bytes: sentences of 4 to 20 words that
+ * start with a capital letter and end with a full stop, with some commas,
+ * in lines of at most LINE_WIDTH characters and an empty line between
+ * paragraphs. Returns the number of words, or -1 on error.
+ *
+ */
+static long writeFile(const char *filename, long size, const double *cdf, int vocabulary, uint64_t *state){
+	char word[64];
+	long written = 0, numWords = 0;
+	int len, column = 0, sentence = 0;
+	FILE *fp;
+
+	if ((fp = fopen(filename, "w")) == NULL) return -1;
+
+	while (written < size) {
+		len = makeWord(drawRank(cdf, vocabulary, state), word);
+		if (sentence == 0) {	//frase nova, comença en majuscula
+			sentence = 4 + nextRandom(state) % 17;
+			word[0] -= 'a' - 'A';
+		}
+
+		if (column > 0 && column + 1 + len + 1 > LINE_WIDTH) {
+			fputc('\n', fp);
+			written++;
+			column = 0;
+		} else if (column > 0) {
+			fputc(' ', fp);
+			written++;
+			column++;
+		}
+
+		fputs(word, fp);
+		written += len;
+		column += len;
+		numWords++;
+
+		if (--sentence == 0) {
+			fputc('.', fp);
+			written++;
+			column++;
+			if (nextRandom(state) % 6 == 0) {	//final de paragraf
+				fputs("\n\n", fp);
+				written += 2;
+				column = 0;
+			}
+		} else if (nextRandom(state) % 12 == 0) {
+			fputc(',', fp);
+			written++;
+			column++;
+		}
+	}
+	if (column > 0) fputc('\n', fp);
+
+	if (fclose(fp) != 0) return -1;
+	return numWords;
+}
+
+
+static void usage(char *name){
+	printf("Us: %s [-n fitxers] [-s bytes | -t bytes] [-d fixed|uniform|pareto] [-v vocabulari] [-z exponent] [-S llavor] directori\n", name);
+	exit(1);
+}
+
+
+int main(int argc, char **argv){
+	int opt, i, numFiles = 10, vocabulary = 50000;
+	long meanSize = 250000, totalSize = 0, *sizes, numWords, totalWords = 0;
+	double exponent = 1.0, *cdf, totalBytes = 0, sumSizes = 0;
+	uint64_t seed = 1, *states;
+	SizeDistribution dist = SIZE_UNIFORM;
+	char path[MAXCHAR + 32];
+	char *dir;
+	FILE *cfg;
+
+	while ((opt = getopt(argc, argv, "n:s:t:d:v:z:S:")) != -1) {
+		switch (opt) {
+			case 'n': numFiles = atoi(optarg); break;
+			case 's': meanSize = atol(optarg); break;
+			case 't': totalSize = atol(optarg); break;
+			case 'v': vocabulary = atoi(optarg); break;
+			case 'z': exponent = atof(optarg); break;
+			case 'S': seed = strtoull(optarg, NULL, 10); break;
+			case 'd':
+				if (strcmp(optarg, "fixed") == 0) dist = SIZE_FIXED;
+				else if (strcmp(optarg, "uniform") == 0) dist = SIZE_UNIFORM;
+				else if (strcmp(optarg, "pareto") == 0) dist = SIZE_PARETO;
+				else usage(argv[0]);
+				break;
+			default: usage(argv[0]);
+		}
+	}
+	if (optind != argc - 1 || numFiles < 1 || numFiles > MAXFILES || meanSize < 1 || totalSize < 0 ||
+			vocabulary < 1 || vocabulary > MAXVOCABULARY || exponent < 0)
+		usage(argv[0]);
+	if (totalSize > 0) {
+		meanSize = totalSize / numFiles;
+		if (meanSize < 1) usage(argv[0]);
+	}
+
+	//els paths dels fitxers han de cabre al buffer de readDatabase
+	dir = argv[optind];
+	if (strlen(dir) + strlen("/files/gen000000.txt") >= MAXCHAR) {
+		printf("El nom del directori '%s' es massa llarg\n", dir);
+		return 1;
+	}
+
+	snprintf(path, sizeof(path), "%s/files", dir);
+	if ((mkdir(dir, 0755) != 0 && errno != EEXIST) || (mkdir(path, 0755) != 0 && errno != EEXIST)) {
+		printf("No s'ha pogut crear el directori '%s'\n", path);
+		return 1;
+	}
+
+	snprintf(path, sizeof(path), "%s/llista.cfg", dir);
+	if ((cfg = fopen(path, "w")) == NULL) {
+		printf("No s'ha pogut crear el fitxer '%s'\n", path);
+		return 1;
+	}
+	fprintf(cfg, "%d\n", numFiles);
+
+	cdf = buildZipf(vocabulary, exponent);
+
+	sizes = malloc(numFiles * sizeof(long));
+	states = malloc(numFiles * sizeof(uint64_t));
+	if (sizes == NULL || states == NULL) {
+		printf("insufficient memory (main)\n");
+		exit(1);
+	}
+	for (i = 0; i < numFiles; i++) {
+		states[i] = seed * 0x100000001b3ULL + i;	//cada fitxer amb el seu generador
+		nextRandom(&states[i]);
+		sizes[i] = drawSize(dist, meanSize, &states[i]);
+		sumSizes += sizes[i];
+	}
+	//amb -t els tamanys s'escalen perque sumin totalSize
+	if (totalSize > 0)
+		for (i = 0; i < numFiles; i++) {
+			sizes[i] = (long) (sizes[i] * (totalSize / sumSizes));
+			if (sizes[i] < 1) sizes[i] = 1;
+		}
+
+	for (i = 0; i < numFiles; i++) {
+		snprintf(path, sizeof(path), "%s/files/gen%06d.txt", dir, i);
+		if ((numWords = writeFile(path, sizes[i], cdf, vocabulary, &states[i])) < 0) {
+			printf("No s'ha pogut escriure el fitxer '%s'\n", path);
+			return 1;
+		}
+		fprintf(cfg, "files/gen%06d.txt\n", i);
+
+		totalWords += numWords;
+		totalBytes += sizes[i];
+	}
+
+	fclose(cfg);
+	free(cdf);
+	free(sizes);
+	free(states);
+
+	printf("%d fitxers, %.1f MB, %ld paraules, vocabulari de %d (z = %.2f)\n", numFiles, totalBytes / 1e6,
+			totalWords, vocabulary, exponent);
+	return 0;
+}
@@ -1,7 +1,7 @@
 /**
  *
- * HashTable implementation. 
- * 
+ * HashTable implementation.
+ *
  * This is an implementation of a hashtable. A minimal
  * set of necessary functions have been included.
  *
@@ -18,22 +18,41 @@
  * quotes.
  */
 #include "hash-table.h"
+#include "metrics.h"
 
+#define HASH_MAXDIST 8	//distancies iguals o mes grans es compten juntes
 
 /**
-* 
-* Funcio que conta el numero de elements a la hashtable local
-* 
-*/
-int countHashtableElems(List *hashtable){
-	int i;
-	int numItems = 0;
+ *
+ * Prints how the table is occupied: load factor, and how far the entries
+ * are from the slot given by their hash value. With a good hash function
+ * almost all entries are at distance 0 or 1.
+ *
+ */
+void reportHashTable(HashTable *hashtable, FILE *fp){
+	int histogram[HASH_MAXDIST + 1] = { 0 };
+	uint64_t mask = hashtable->size - 1;
+	int i, dist, maxDist = 0;
+	long sumDist = 0;
+
+	for (i = 0; i < hashtable->size; i++) {
+		if (hashtable->entries[i].primary_key == NULL) continue;
+
+		dist = (i - (hashtable->entries[i].hash & mask)) & mask;
+		sumDist += dist;
+		if (dist > maxDist) maxDist = dist;
+		histogram[dist < HASH_MAXDIST ? dist : HASH_MAXDIST]++;
+	}
 
-	for(i = 0; i < HASHSIZE; i++) {
-		numItems += hashtable[i].numItems;
-		printf("hashtable[%d]numItems:\t%d\n", i, hashtable[i].numItems);
+	fprintf(fp, "hashtable: %d entries, %d words, load %.2f\n", hashtable->size,
+			hashtable->numItems, (double) hashtable->numItems / hashtable->size);
+	fprintf(fp, "hashtable: mean probe distance %.3f, max %d\n",
+			hashtable->numItems ? (double) sumDist / hashtable->numItems : 0.0, maxDist);
+	for (i = 0; i <= HASH_MAXDIST; i++) {
+		if (histogram[i] == 0) continue;
+		fprintf(fp, "hashtable: distance %s%d\t%d\t%.2f%%\n", i == HASH_MAXDIST ? ">=" : "", i,
+				histogram[i], 100.0 * histogram[i] / hashtable->numItems);
 	}
-	return numItems;
 }
 
 /**
@@ -41,46 +60,291 @@ int countHashtableElems(List *hashtable){
  * Deletes the hash table
  *
  */
-void freeHashTable(List *hashTable, int size){
+void freeHashTable(HashTable *hashTable){
+	deleteArena(&(hashTable->keys));	//les paraules s'alliberen de cop
+	free(hashTable->entries);
+	free(hashTable);
+}
+
+
+/**
+ *
+ * Allocates the vector of entries. All of them are free.
+ *
+ */
+static HashEntry *allocEntries(int size){
+	HashEntry *entries;
+
+	entries = calloc(size, sizeof(HashEntry));
+	if (entries == NULL) {
+		printf("insufficient memory (allocHashTable)\n");
+		exit(1);
+	}
+	return entries;
+}
+
+
+/**
+ *
+ * Allocates memory for the hashTable. The size is rounded up to a power
+ * of two; the table grows by itself when it gets full.
+ *
+ */
+HashTable *allocHashTable(int size){
+	HashTable *hashTable;
+	int n = 16;
+
+	while (n < size) n <<= 1;
+
+	hashTable = malloc(sizeof(HashTable));
+	if (hashTable == NULL) {
+		printf("insufficient memory (allocHashTable)\n");
+		exit(1);
+	}
+	hashTable->entries = allocEntries(n);
+	hashTable->size = n;
+	hashTable->numItems = 0;
+	initArena(&(hashTable->keys), ARENA_BLOCKSIZE);
+
+	return hashTable;
+}
+
+
+/**
+ *
+ * Places an entry that is known not to be in the table. Starting at its
+ * home slot, whenever the entry is further from home than the one found
+ * in the slot they are swapped and the displaced entry goes on probing.
+ *
+ */
+static void placeEntry(HashTable *hashTable, HashEntry entry, int slot, int dist){
+	uint64_t mask = hashTable->size - 1;
+	HashEntry *current, tmp;
+	int currentDist;
+
+	while (1) {
+		current = &(hashTable->entries[slot]);
+		if (current->primary_key == NULL) {
+			*current = entry;
+			return;
+		}
+
+		currentDist = (slot - (current->hash & mask)) & mask;
+		if (currentDist < dist) {
+			tmp = *current;
+			*current = entry;
+			entry = tmp;
+			dist = currentDist;
+		}
+		slot = (slot + 1) & mask;
+		dist++;
+	}
+}
+
+
+/**
+ *
+ * Doubles the size of the table. The entries are moved with their stored
+ * hash value, the words are not touched.
+ *
+ */
+static void growHashTable(HashTable *hashTable){
+	HashEntry *old = hashTable->entries;
+	int i, oldSize = hashTable->size;
+
+	hashTable->size = oldSize * 2;
+	hashTable->entries = allocEntries(hashTable->size);
+
+	for (i = 0; i < oldSize; i++) {
+		if (old[i].primary_key != NULL)
+			placeEntry(hashTable, old[i], old[i].hash & (hashTable->size - 1), 0);
+	}
+	free(old);
+}
+
+
+/**
+ *
+ * Adds numTimes appearances of a word. If the word is new, key is the
+ * copy stored in the entry, or NULL to copy word into the arena.
+ *
+ */
+static void addHashEntry(HashTable *hashTable, const char *word, int len, uint64_t hash, int numTimes, char *key){
+	HashEntry *current, entry;
+	uint64_t mask;
+	int slot, dist = 0;
+
+	if ((hashTable->numItems + 1) * 100 > hashTable->size * HASH_MAXLOAD) growHashTable(hashTable);
+
+	mask = hashTable->size - 1;
+	slot = hash & mask;
+
+	while (1) {
+		current = &(hashTable->entries[slot]);
+
+		// una entrada lliure, o una que es mes a prop de casa que nosaltres: la paraula no hi es
+		if (current->primary_key == NULL || (int) ((slot - (current->hash & mask)) & mask) < dist) break;
+
+		if (current->hash == hash && current->len == len && memcmp(current->primary_key, word, len) == 0) {
+			// si la trobem incrementem el numero de cops de aparicio
+			current->numTimes += numTimes;
+			METRICS_ADD(METRIC_PROBES, dist + 1);
+			return;
+		}
+		slot = (slot + 1) & mask;
+		dist++;
+	}
+
+	// si la paraula no esta, creem una nova entrada amb paraula com a clau
+	entry.primary_key = key ? key : copyStringArena(&(hashTable->keys), word, len);
+	entry.hash = hash;
+	entry.len = len;
+	entry.numTimes = numTimes;
+	placeEntry(hashTable, entry, slot, dist);
+	hashTable->numItems++;
+	METRICS_ADD(METRIC_PROBES, dist + 1);
+}
+
+
+/**
+ *
+ * Inserts a word of len characters in the hash table, or increments its
+ * counter if it is already there. The word has to be null terminated but
+ * it is not stored: a copy is done into the arena of the table only the
+ * first time the word is seen. hash is getHashValue(word, len), computed
+ * by the caller.
+ *
+ */
+void insertHashTable(HashTable *hashTable, char *word, int len, uint64_t hash){
+	addHashEntry(hashTable, word, len, hash, 1, NULL);
+	METRICS_ADD(METRIC_WORDS, 1);
+}
+
+
+/**
+ *
+ * Adds the counters of src to dst and frees src. The words of src are not
+ * copied: its arena is moved to dst, and the new entries keep pointing to
+ * them.
+ *
+ */
+void mergeHashTable(HashTable *dst, HashTable *src){
+	HashEntry *entry;
 	int i;
-	for(i = 0; i < size; i++){
-		//dumpList(&(hashTable[i]));	//En finalizar el processament local imprimim el nombre de vegades que apareix cada paraula al text.
-		deleteList(&(hashTable[i]));
+
+	for (i = 0; i < src->size; i++) {
+		entry = &(src->entries[i]);
+		if (entry->primary_key != NULL)
+			addHashEntry(dst, entry->primary_key, entry->len, entry->hash, entry->numTimes, entry->primary_key);
 	}
-	free(hashTable);
+
+	moveArena(&(dst->keys), &(src->keys));
+	freeHashTable(src);
 }
 
 
+#if HASH_FUNCTION == HASH_WYHASH
+
+/*
+ * Lectures de 8, 4 i 1 a 3 bytes sense requisits d'alineament.
+ */
+static inline uint64_t read64(const unsigned char *p){
+	uint64_t v;
+	memcpy(&v, p, 8);
+	return v;
+}
+
+static inline uint64_t read32(const unsigned char *p){
+	uint32_t v;
+	memcpy(&v, p, 4);
+	return v;
+}
+
+static inline uint64_t read3(const unsigned char *p, int len){
+	return ((uint64_t) p[0] << 16) | ((uint64_t) p[len >> 1] << 8) | p[len - 1];
+}
+
+/*
+ * 64x64 bit multiplication folded to 64 bits.
+ */
+static inline uint64_t mix(uint64_t a, uint64_t b){
+	__uint128_t r = (__uint128_t) a * b;
+	return (uint64_t) r ^ (uint64_t) (r >> 64);
+}
+
+#define WY_SECRET0 0xa0761d6478bd642full
+#define WY_SECRET1 0xe7037ed1a0b428dbull
+
 /**
  *
- * Allocates memory for the hashTable. The hash table is made up of a vector
- * of linked lists. Each list is initialized with zero elements.
+ * This function returns the hash value for a given string of len
+ * characters. It follows wyhash: short strings are read with two
+ * overlapping loads, so a word costs a couple of multiplications.
  *
  */
-List *allocHashTable(int size){
+uint64_t getHashValue(const char *cadena, int len){
+	const unsigned char *p = (const unsigned char *) cadena;
+	uint64_t a, b, seed = WY_SECRET0;
 	int i;
-	List *hashTable;
 
-	hashTable = malloc(sizeof(List) * size);
-	for(i = 0; i < size; i++) initList(&(hashTable[i]));
+	if (len <= 16) {
+		if (len >= 4) {
+			a = (read32(p) << 32) | read32(p + ((len >> 3) << 2));
+			b = (read32(p + len - 4) << 32) | read32(p + len - 4 - ((len >> 3) << 2));
+		} else if (len > 0) {
+			a = read3(p, len);
+			b = 0;
+		} else {
+			a = b = 0;
+		}
+	} else {
+		for (i = len; i > 16; i -= 16, p += 16)
+			seed = mix(read64(p) ^ WY_SECRET1, read64(p + 8) ^ seed);
+		a = read64(p + i - 16);
+		b = read64(p + i - 8);
+	}
+	return mix(WY_SECRET1 ^ len, mix(a ^ WY_SECRET1, b ^ seed));
+}
 
-	return hashTable;
+#elif HASH_FUNCTION == HASH_FNV1A
+
+/**
+ *
+ * This function returns the 64 bit FNV-1a hash value for a given string
+ * of len characters.
+ *
+ */
+uint64_t getHashValue(const char *cadena, int len){
+	uint64_t hash = 0xcbf29ce484222325ull;
+	int i;
+
+	for (i = 0; i < len; i++) {
+		hash ^= (unsigned char) cadena[i];
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
 }
 
+#else
 
 /**
  *
  * This function returns the hash value for a given string
- * Function from file hash.c
+ * Function from file hash.c, with a final mix that spreads the bits
+ * because the table keeps only the lowest ones.
+ *
  */
-int getHashValue(char *cadena){
-	unsigned int i, len, seed, sum, hash;
+uint64_t getHashValue(const char *cadena, int len){
+	uint64_t i, seed, sum;
 
-	len = strlen(cadena); 
 	sum = 0;
 	seed = 131;
 	for(i = 0; i < len; i++) sum = sum * seed + (int)cadena[i];
 
-	hash = sum % HASHSIZE;
-	return hash;
+	sum ^= sum >> 33;
+	sum *= 0xff51afd7ed558ccdull;
+	sum ^= sum >> 33;
+	return sum;
 }
+
+#endif
@@ -1,8 +1,8 @@
 /**
  *
- * HashTable header 
- * 
- * Include this file in order to be able to call the 
+ * HashTable header
+ *
+ * Include this file in order to be able to call the
  * functions available in hash-table.c. We include
  * here only those information we want to make visible
  * to other files.
@@ -11,15 +11,72 @@
  *
  */
 
-#include "linked-list.h"
+#ifndef HASH_TABLE_H
+#define HASH_TABLE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "arena.h"
 
 /**
- * 
- * The HASHSIZE is used to define the number of entries of the
- * hash-table array.
+ *
+ * The HASHSIZE is used to define the initial number of entries of the
+ * hash-table array. It has to be a power of two. The table doubles its
+ * size when it is HASH_MAXLOAD percent full.
  *
  */
-#define HASHSIZE  10000	 //numero de elements de la taula hash
+#define HASHSIZE  1024	 //numero inicial de elements de la taula hash
+#define HASH_MAXLOAD 75
+
+#define MAX_WORDCHR 75		//long. maxima per buffer de paraula
+
+/**
+ *
+ * Hash function used for the words. HASH_WYHASH mixes 8 bytes at a time
+ * with a 64x64->128 bit multiplication, HASH_FNV1A is the classic byte by
+ * byte FNV-1a and HASH_MULT131 is the original function of hash.c. The
+ * value is computed once by the tokenizer and then stored with the word in
+ * the hash table, in the tree and in the saved files, so a file saved with
+ * one function has to be loaded by a program built with the same one.
+ *
+ */
+#define HASH_WYHASH  1
+#define HASH_FNV1A   2
+#define HASH_MULT131 3
+
+#define HASH_FUNCTION HASH_WYHASH
+
+/**
+ *
+ * Each entry of the table holds a word and the number of times it appears
+ * in the file. The full hash value is stored so that probes compare it
+ * before the key and the table can grow without hashing the words again.
+ * An entry is free when primary_key is NULL.
+ *
+ */
+typedef struct HashEntry_ {
+	char *primary_key;	/* paraula, guardada a l'arena de la taula */
+	uint64_t hash;		/* valor hash complet de la paraula */
+	int len;			/* longitud de la paraula */
+	int numTimes;		/* numero de cops que apareix en un fitxer */
+} HashEntry;
+
+/**
+ *
+ * Open addressing hash table with linear probing and robin hood
+ * insertion: an entry never sits further from its home slot than the
+ * entries it has passed, which keeps the probe sequences short. The words
+ * are copied into the "keys" arena, so they are released all together
+ * with the table.
+ *
+ */
+typedef struct HashTable_ {
+	HashEntry *entries;	/* vector de entrades */
+	int size;			/* nombre de entrades del vector (potencia de 2) */
+	int numItems;		/* nombre de entrades ocupades */
+	Arena keys;			/* memoria on es guarden les paraules */
+} HashTable;
 
 /**
  *
@@ -27,7 +84,11 @@
  * can be called from any other file.
  *
  */
-int getHashValue(char *cadena);
-int countHashtableElems(List *hashtable);
-List *allocHashTable(int size);
-void freeHashTable(List *hashTable, int size);
+uint64_t getHashValue(const char *cadena, int len);
+void reportHashTable(HashTable *hashtable, FILE *fp);
+HashTable *allocHashTable(int size);
+void insertHashTable(HashTable *hashTable, char *word, int len, uint64_t hash);
+void mergeHashTable(HashTable *dst, HashTable *src);
+void freeHashTable(HashTable *hashTable);
+
+#endif
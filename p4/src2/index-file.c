@@ -0,0 +1,352 @@
+/**
+ *
+ * Index file implementation.
+ *
+ * Binary format of the index that can be mapped in memory and queried in
+ * place, without reading it into a tree. See index-file.h for the layout.
+ *
+ * Igor Dzinka / Vicent Roig, 2014.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <limits.h>
+#include <sys/mman.h>
+
+/**
+ * We include the index-file.h header. Note the double
+ * quotes.
+ */
+#include "index-file.h"
+
+
+/**
+ *
+ * Checksum of n bytes, 8 bytes at a time.
+ *
+ */
+static uint64_t checksumBytes(const unsigned char *p, size_t n){
+	uint64_t h = 0x9e3779b97f4a7c15ULL, w;
+
+	while (n >= 8) {
+		memcpy(&w, p, 8);
+		h = (h ^ w) * 0xff51afd7ed558ccdULL;
+		h ^= h >> 32;
+		p += 8;
+		n -= 8;
+	}
+
+	w = 0;
+	memcpy(&w, p, n);
+	h = (h ^ w ^ n) * 0xff51afd7ed558ccdULL;
+	h ^= h >> 32;
+
+	return h;
+}
+
+static uint64_t checksumHeader(const IndexFileHeader *header){
+	return checksumBytes((const unsigned char *) header, offsetof(IndexFileHeader, headerChecksum));
+}
+
+
+/**
+ *
+ * Writes the index to filename in the format of index-file.h. The file is
+ * written with another name and renamed at the end, so a failed save does
+ * not destroy the old file, and an index mapped from filename can be
+ * saved over it. The data checksum is computed once the file is written,
+ * reading it back. Returns 0, or -1 if the index is empty or the file can
+ * not be written.
+ *
+ */
+int writeIndexFile(Index *index, char *filename){
+	IndexFileHeader header;
+	IndexFileEntry *entries;
+	RBData **words;
+	IndexIterator it;
+	MappedFile file;
+	RBData *data;
+	FILE *fp;
+	char *tmpname;
+	int i, rc, numWords = getIndexNumNodes(index);
+
+	if (numWords == 0) return -1;
+
+	entries = calloc(numWords, sizeof(IndexFileEntry));
+	words = malloc(sizeof(RBData *) * numWords);
+	tmpname = malloc(strlen(filename) + 5);
+	if (entries == NULL || words == NULL || tmpname == NULL) {
+		printf("insufficient memory (writeIndexFile)\n");
+		exit(1);
+	}
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, INDEXFILE_MAGIC, sizeof(header.magic));
+	header.version = INDEXFILE_VERSION;
+	header.sizeDb = index->sizeDb;
+	header.numWords = numWords;
+
+	// primera passada: directori i mida de cada zona
+	i = 0;
+	initIndexIterator(&it, index);
+	while (i < numWords && (data = nextIndex(&it)) != NULL) {
+		words[i] = data;
+		entries[i].hash = data->hash;
+		entries[i].keyOffset = header.poolSize;
+		entries[i].keyLen = strlen(data->primary_key);
+		entries[i].numFiles = data->numFiles;
+		entries[i].postingsOffset = header.postingsSize;
+		entries[i].postingsLen = data->postings.len;
+		entries[i].lastFile = data->postings.lastFile;
+
+		header.poolSize += entries[i].keyLen + 1;
+		header.postingsSize += data->postings.len;
+		i++;
+	}
+	numWords = header.numWords = i;	//les entrades malmeses d'un fitxer no hi son
+
+	header.dirOffset = sizeof(IndexFileHeader);
+	header.poolOffset = header.dirOffset + (uint64_t) numWords * sizeof(IndexFileEntry);
+	header.postingsOffset = header.poolOffset + header.poolSize;
+
+	sprintf(tmpname, "%s.tmp", filename);
+	fp = (header.poolSize <= UINT32_MAX) ? fopen(tmpname, "w") : NULL;
+	rc = (fp == NULL) ? -1 : 0;
+
+	// la capçalera es torna a escriure al final, amb els checksums
+	if (rc == 0 && fwrite(&header, sizeof(header), 1, fp) != 1) rc = -1;
+	if (rc == 0 && fwrite(entries, sizeof(IndexFileEntry), numWords, fp) != (size_t) numWords) rc = -1;
+	for (i = 0; rc == 0 && i < numWords; i++)
+		if (fwrite(words[i]->primary_key, sizeof(char), entries[i].keyLen + 1, fp) != entries[i].keyLen + 1) rc = -1;
+	for (i = 0; rc == 0 && i < numWords; i++)
+		if (fwrite(words[i]->postings.bytes, sizeof(char), words[i]->postings.len, fp) != (size_t) words[i]->postings.len) rc = -1;
+	if (fp != NULL && fclose(fp) != 0) rc = -1;
+
+	free(entries);
+	free(words);
+
+	if (rc == 0 && mapFile(tmpname, &file) != 0) rc = -1;
+	if (rc == 0) {
+		header.dataChecksum = checksumBytes((unsigned char *) file.data + header.dirOffset, file.size - header.dirOffset);
+		unmapFile(&file);
+		header.headerChecksum = checksumHeader(&header);
+
+		fp = fopen(tmpname, "r+");
+		if (fp == NULL || fwrite(&header, sizeof(header), 1, fp) != 1) rc = -1;
+		if (fp != NULL && fclose(fp) != 0) rc = -1;
+	}
+
+	if (rc == 0 && rename(tmpname, filename) != 0) rc = -1;
+	if (rc != 0) remove(tmpname);	//fitxer a mitges
+	free(tmpname);
+
+	return rc;
+}
+
+
+/**
+ *
+ * Returns 1 if filename starts with the magic of the format, 0 otherwise
+ * (for instance, a tree file of the earlier versions).
+ *
+ */
+int isIndexFile(char *filename){
+	char magic[8];
+	FILE *fp;
+	int rc = 0;
+
+	fp = fopen(filename, "r");
+	if (fp == NULL) return 0;
+	if (fread(magic, sizeof(char), sizeof(magic), fp) == sizeof(magic))
+		rc = (memcmp(magic, INDEXFILE_MAGIC, sizeof(magic)) == 0);
+	fclose(fp);
+
+	return rc;
+}
+
+
+/**
+ *
+ * Checks one entry of the directory: key inside the pool, of at most
+ * MAX_WORDCHR characters and with its hash value, and posting list inside
+ * its zone that decodes to numFiles postings of files of the database.
+ * The cost is the length of the key and of the list, so an entry can be
+ * checked when it is used. Returns 0, or -1 if the entry is damaged.
+ *
+ */
+int checkIndexFileEntry(MappedIndex *mi, int entry){
+	const IndexFileHeader *header = mi->header;
+	const IndexFileEntry *e = &(mi->entries[entry]);
+	const char *key;
+	int numFiles, lastFile;
+
+	if ((uint64_t) e->keyOffset + e->keyLen >= header->poolSize) return -1;
+	if (e->keyLen < 1 || e->keyLen > MAX_WORDCHR) return -1;
+	key = mi->pool + e->keyOffset;
+	if (key[e->keyLen] != '\0' || strlen(key) != e->keyLen) return -1;
+	if (e->hash != getHashValue(key, e->keyLen)) return -1;
+
+	// la llista s'ha de poder recorrer sense sortir-ne ni del fitxer
+	if (e->postingsOffset > header->postingsSize ||
+			e->postingsLen > header->postingsSize - e->postingsOffset ||
+			e->postingsLen > INT_MAX) return -1;
+	if (checkPostingList(mi->postings + e->postingsOffset, e->postingsLen, header->sizeDb,
+			&numFiles, &lastFile) != 0) return -1;
+	if (numFiles != e->numFiles || lastFile != e->lastFile) return -1;
+
+	return 0;
+}
+
+
+/**
+ *
+ * Checks every entry of the directory, and that the keys are strictly
+ * increasing, which the binary searches need.
+ *
+ */
+static int checkEntries(MappedIndex *mi){
+	uint32_t i;
+
+	for (i = 0; i < mi->header->numWords; i++) {
+		if (checkIndexFileEntry(mi, i) != 0) return -1;
+		if (i > 0 && strcmp(getIndexFileKey(mi, i - 1), getIndexFileKey(mi, i)) >= 0) return -1;
+	}
+	return 0;
+}
+
+
+/**
+ *
+ * Maps an index file. Only the header and the last byte of the pool are
+ * read, so the cost does not depend on the size of the index: the entries
+ * are checked with checkIndexFileEntry when they are used. With verify
+ * the data checksum and all the directory are checked too, reading the
+ * whole file. Returns 0, or -1 if the file can not be mapped or is not
+ * valid.
+ *
+ */
+int openIndexFile(char *filename, MappedIndex *mi, int verify){
+	const IndexFileHeader *header;
+	uint64_t size;
+
+	if (mapFile(filename, &(mi->file)) != 0) return -1;
+	size = mi->file.size;
+	header = (const IndexFileHeader *) mi->file.data;
+
+	if (size < sizeof(IndexFileHeader) ||
+			memcmp(header->magic, INDEXFILE_MAGIC, sizeof(header->magic)) != 0 ||
+			header->version != INDEXFILE_VERSION ||
+			header->headerChecksum != checksumHeader(header) ||
+			header->dirOffset != sizeof(IndexFileHeader) ||
+			header->poolOffset != header->dirOffset + (uint64_t) header->numWords * sizeof(IndexFileEntry) ||
+			header->postingsOffset != header->poolOffset + header->poolSize ||
+			header->postingsOffset > size || header->postingsSize != size - header->postingsOffset ||
+			header->sizeDb < 1 || header->sizeDb > INT_MAX || header->numWords > INT_MAX || header->poolSize > size ||
+			(header->numWords > 0 && header->poolSize == 0)) {
+		unmapFile(&(mi->file));
+		return -1;
+	}
+
+	mi->header = header;
+	mi->entries = (const IndexFileEntry *) (mi->file.data + header->dirOffset);
+	mi->pool = mi->file.data + header->poolOffset;
+	mi->postings = (const unsigned char *) mi->file.data + header->postingsOffset;
+
+	// amb el pool acabat en '\0' cap strcmp d'una clau en pot sortir
+	if (header->poolSize > 0 && mi->pool[header->poolSize - 1] != '\0') {
+		unmapFile(&(mi->file));
+		return -1;
+	}
+
+	if (verify && (header->dataChecksum != checksumBytes((unsigned char *) mi->file.data + header->dirOffset, size - header->dirOffset) ||
+			checkEntries(mi) != 0)) {
+		unmapFile(&(mi->file));
+		return -1;
+	}
+
+	// les consultes salten pel fitxer, no el llegeixen d'inici a fi
+	if (mi->file.mapped) madvise(mi->file.data, mi->file.size, MADV_RANDOM);
+
+	return 0;
+}
+
+
+/**
+ *
+ * Unmaps the index file.
+ *
+ */
+void closeIndexFile(MappedIndex *mi){
+	unmapFile(&(mi->file));
+	mi->header = NULL;
+	mi->entries = NULL;
+	mi->pool = NULL;
+	mi->postings = NULL;
+}
+
+
+/**
+ *
+ * Binary search of the first entry with a word >= primary_key. Returns
+ * numWords if there is none. The entries that follow it are the next
+ * words in order, so a range or a prefix is a walk from here.
+ *
+ */
+int lowerBoundIndexFile(MappedIndex *mi, const char *primary_key){
+	int lo = 0, hi = (int) mi->header->numWords, mid;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (strcmp(getIndexFileKey(mi, mid), primary_key) < 0) lo = mid + 1;
+		else hi = mid;
+	}
+	return lo;
+}
+
+
+/**
+ *
+ * Binary search of a word in the directory. Returns its entry, or -1 if
+ * it is not in the index.
+ *
+ */
+int findIndexFile(MappedIndex *mi, const char *primary_key){
+	int entry = lowerBoundIndexFile(mi, primary_key);
+
+	if (entry < (int) mi->header->numWords && strcmp(primary_key, getIndexFileKey(mi, entry)) == 0) return entry;
+	return -1;
+}
+
+
+/**
+ *
+ * Returns the word of an entry, inside the mapping. The key of an entry
+ * that points outside the pool is the empty string, so the binary
+ * searches never read outside the file.
+ *
+ */
+const char *getIndexFileKey(MappedIndex *mi, int entry){
+	if (mi->entries[entry].keyOffset >= mi->header->poolSize) return "";
+	return mi->pool + mi->entries[entry].keyOffset;
+}
+
+
+/**
+ *
+ * Makes list point to the postings of an entry, inside the mapping. The
+ * list can be read with a PostingIterator or getPostingCount, once the
+ * entry has been checked, but it must not be modified.
+ *
+ */
+void getIndexFilePostings(MappedIndex *mi, int entry, PostingList *list){
+	const IndexFileEntry *e = &(mi->entries[entry]);
+
+	list->bytes = (unsigned char *) mi->postings + e->postingsOffset;
+	list->len = e->postingsLen;
+	list->cap = e->postingsLen;
+	list->sorted = e->postingsLen;
+	list->lastFile = e->lastFile;
+}
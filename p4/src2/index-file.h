@@ -0,0 +1,97 @@
+/**
+ *
+ * Index file header
+ *
+ * Include this file in order to be able to call the
+ * functions available in index-file.c. We include
+ * here only those information we want to make visible
+ * to other files.
+ *
+ * Igor Dzinka / Vicent Roig, 2014.
+ *
+ */
+#ifndef INDEX_FILE_H
+#define INDEX_FILE_H
+
+#include <stdint.h>
+#include "index.h"
+#include "tokenizer.h"
+
+/**
+ *
+ * File layout. All the numbers are in the byte order of the machine that
+ * wrote the file, and all the offsets are from the start of the file:
+ *
+ *   header     IndexFileHeader
+ *   directory  numWords IndexFileEntry, sorted by key
+ *   pool       the keys, each one ended by '\0'
+ *   postings   the posting lists, as they are in memory (posting-list.h)
+ *
+ * The file can be used in place once mapped: the words are found with a
+ * binary search on the directory and the postings are read directly from
+ * the mapping. The header has its own checksum, which is always checked;
+ * dataChecksum covers the rest of the file and is only checked on demand,
+ * because it means reading the whole file. Without it, each entry is
+ * checked with checkIndexFileEntry before its key and postings are used.
+ *
+ */
+#define INDEXFILE_MAGIC "SO2INDEX"
+#define INDEXFILE_VERSION 1
+
+typedef struct IndexFileHeader_ {
+	char magic[8];				/* INDEXFILE_MAGIC, sense '\0' */
+	uint32_t version;
+	uint32_t sizeDb;			/* fitxers de la base de dades */
+	uint32_t numWords;
+	uint32_t reserved;
+	uint64_t dirOffset;
+	uint64_t poolOffset;
+	uint64_t poolSize;
+	uint64_t postingsOffset;
+	uint64_t postingsSize;
+	uint64_t dataChecksum;		/* de dirOffset fins al final del fitxer */
+	uint64_t headerChecksum;	/* dels camps anteriors */
+} IndexFileHeader;
+
+typedef struct IndexFileEntry_ {
+	uint64_t hash;				/* getHashValue de la paraula */
+	uint64_t postingsOffset;	/* dins de la zona de postings */
+	uint32_t keyOffset;			/* dins del pool */
+	uint32_t keyLen;
+	uint32_t numFiles;
+	uint32_t postingsLen;		/* bytes de la llista */
+	int32_t lastFile;			/* fileId mes gran de la llista */
+	uint32_t reserved;
+} IndexFileEntry;
+
+/**
+ *
+ * An index file opened with openIndexFile. The pointers point inside the
+ * mapping of the file.
+ *
+ */
+typedef struct MappedIndex_ {
+	MappedFile file;
+	const IndexFileHeader *header;
+	const IndexFileEntry *entries;
+	const char *pool;
+	const unsigned char *postings;
+} MappedIndex;
+
+/**
+ *
+ * Function heders we want to make visible so that they
+ * can be called from any other file.
+ *
+ */
+int writeIndexFile(Index *index, char *filename);
+int isIndexFile(char *filename);
+int openIndexFile(char *filename, MappedIndex *mi, int verify);
+int checkIndexFileEntry(MappedIndex *mi, int entry);
+void closeIndexFile(MappedIndex *mi);
+int lowerBoundIndexFile(MappedIndex *mi, const char *primary_key);
+int findIndexFile(MappedIndex *mi, const char *primary_key);
+const char *getIndexFileKey(MappedIndex *mi, int entry);
+void getIndexFilePostings(MappedIndex *mi, int entry, PostingList *list);
+
+#endif
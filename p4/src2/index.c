@@ -0,0 +1,759 @@
+/**
+ *
+ * Index implementation.
+ *
+ * Global index of the words of the database, split in shards by hash
+ * value. Each shard is a red-black tree protected by its own lock, so
+ * the merge of the local hash tables can run in parallel. The order of
+ * the words is recovered by merging the in-order walks of the shards.
+ *
+ * Igor Dzinka / Vicent Roig, 2014.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * We include the index.h header. Note the double
+ * quotes.
+ */
+#include "index.h"
+#include "index-file.h"
+#include "phase.h"
+
+static LockSite siteShards = LOCK_SITE("locks dels shards");
+static int verifyIndexFiles = 0;	//1 si loadIndex comprova tot el fitxer
+
+/**
+ * support functions prototypes
+ */
+static void buildShards(Index *index, RBData **records, int numRecords, int part, int numParts);
+static void copyIndexFile(Index *index);
+
+
+/**
+ *
+ * Initialize an empty index for a database of sizeDb files.
+ *
+ */
+void initIndex(Index *index, int sizeDb){
+	int i;
+
+	for (i = 0; i < NSHARDS; i++) {
+		initTree(&(index->shards[i]));
+		index->shards[i].sizeDb = sizeDb;
+		pthread_mutex_init(&(index->locks[i]), NULL);
+	}
+	index->sizeDb = sizeDb;
+	index->frozen = 0;
+	index->file = NULL;
+	index->views = NULL;
+}
+
+
+/**
+ *
+ * Returns the data of an entry of the file of the index. It is made the
+ * first time the entry is used, once checkIndexFileEntry has checked it:
+ * the key and the postings point inside the mapping. Returns NULL if the
+ * entry is damaged.
+ *
+ */
+static RBData *getMappedData(Index *index, int entry){
+	RBData *data = &(index->views[entry]);
+
+	if (data->primary_key != NULL) return data;
+	if (data->numFiles < 0) return NULL;	//ja sabem que es malmesa
+
+	if (checkIndexFileEntry(index->file, entry) != 0) {
+		data->numFiles = -1;
+		return NULL;
+	}
+	data->hash = index->file->entries[entry].hash;
+	data->numFiles = index->file->entries[entry].numFiles;
+	getIndexFilePostings(index->file, entry, &(data->postings));
+	data->primary_key = (char *) getIndexFileKey(index->file, entry);
+
+	return data;
+}
+
+
+/**
+ *
+ * Unmaps the file of the index and frees the data of its entries.
+ *
+ */
+static void unmapIndex(Index *index){
+	closeIndexFile(index->file);
+	free(index->file);
+	free(index->views);
+	index->file = NULL;
+	index->views = NULL;
+	index->frozen = 0;
+}
+
+
+/**
+ *
+ * Deletes all the shards of the index. The index can not be used again
+ * until initIndex is called.
+ *
+ */
+void deleteIndex(Index *index){
+	int i;
+
+	if (index->file) unmapIndex(index);	//no cal fer els arbres
+	thawIndex(index);
+	for (i = 0; i < NSHARDS; i++) {
+		deleteTree(&(index->shards[i]));
+		pthread_mutex_destroy(&(index->locks[i]));
+	}
+}
+
+
+/**
+ *
+ * Builds the read-only lookup arrays of all the shards. findIndex and
+ * lookupWords use them until the index is thawed.
+ *
+ */
+void freezeIndex(Index *index){
+	int i;
+
+	if (index->frozen || INDEX_LOOKUP == LOOKUP_RBTREE) return;
+	for (i = 0; i < NSHARDS; i++) {
+#if INDEX_LOOKUP == LOOKUP_ART
+		buildArt(&(index->lookup[i]), &(index->shards[i]));
+#else
+		buildEytzinger(&(index->lookup[i]), &(index->shards[i]));
+#endif
+	}
+	index->frozen = 1;
+}
+
+
+/**
+ *
+ * Frees the lookup arrays, so the index can be modified. An index used
+ * from its file gets its trees now.
+ *
+ */
+void thawIndex(Index *index){
+	int i;
+
+	if (!index->frozen) return;
+	if (index->file) {
+		copyIndexFile(index);
+		return;
+	}
+	for (i = 0; i < NSHARDS; i++) {
+#if INDEX_LOOKUP == LOOKUP_ART
+		deleteArt(&(index->lookup[i]));
+#else
+		freeEytzinger(&(index->lookup[i]));
+#endif
+	}
+	index->frozen = 0;
+}
+
+
+/**
+ *
+ * Sorts the posting lists that got files out of order while the index
+ * was built (see addPosting). It is called once all the files have been
+ * merged, before the index is read.
+ *
+ */
+void sortIndexPostings(Index *index){
+	Node *node;
+	int i;
+
+	for (i = 0; i < NSHARDS; i++)
+		for (node = firstNode(&(index->shards[i])); node != NULL; node = nextNode(node))
+			sortPostingList(&(node->data->postings));
+}
+
+
+/**
+ *
+ * Grows the database of the index with numFiles new files. Returns the
+ * fileId of the first one; the others follow it.
+ *
+ */
+int extendIndex(Index *index, int numFiles){
+	int i, firstFile = index->sizeDb;
+
+	index->sizeDb += numFiles;
+	for (i = 0; i < NSHARDS; i++) index->shards[i].sizeDb = index->sizeDb;
+
+	return firstFile;
+}
+
+
+/**
+ *
+ * Adds the word of a local hash table entry to shard s. The tree is
+ * searched with the hash value of the entry, and only the new words are
+ * inserted. The caller holds the lock of the shard.
+ *
+ */
+static void mergeHashEntry(Index *index, int s, HashEntry *entry, int idFile){
+	RBTree *tree = &(index->shards[s]);
+	RBData *data;
+
+	data = findNodeHash(tree, entry->primary_key, entry->hash);
+	if (data == NULL) {
+		data = allocRBData(tree, entry->primary_key, entry->len, entry->hash);
+		insertNode(tree, data);
+		METRICS_ADD(METRIC_INDEX_WORDS, 1);
+	}
+
+	data->numFiles++;
+	addPosting(&(data->postings), &(tree->arena), idFile, entry->numTimes);
+}
+
+
+/**
+ *
+ * Returns the number of different words of the index.
+ *
+ */
+int getIndexNumNodes(Index *index){
+	int i, numNodes = 0;
+
+	if (index->file) return index->file->header->numWords;
+	for (i = 0; i < NSHARDS; i++) numNodes += index->shards[i].numNodes;
+	return numNodes;
+}
+
+
+/**
+ *
+ * Finds the data of a word, NULL if it is not in the index. It does not
+ * take the lock of the shard: it is meant to be used once the index is
+ * built.
+ *
+ */
+RBData *findIndex(Index *index, char *primary_key){
+	return findIndexHash(index, primary_key, getHashValue(primary_key, strlen(primary_key)));
+}
+
+
+/**
+ *
+ * Same as findIndex, for a word whose hash value is already known.
+ *
+ */
+RBData *findIndexHash(Index *index, char *primary_key, uint64_t hash){
+	int entry;
+
+	if (index->file) {
+		entry = findIndexFile(index->file, primary_key);
+		return entry < 0 ? NULL : getMappedData(index, entry);
+	}
+#if INDEX_LOOKUP == LOOKUP_ART
+	if (index->frozen) return findArt(&(index->lookup[SHARD(hash)]), primary_key);
+#elif INDEX_LOOKUP == LOOKUP_EYTZINGER
+	if (index->frozen) return findEytzinger(&(index->lookup[SHARD(hash)]), primary_key);
+#endif
+	return findNodeHash(&(index->shards[SHARD(hash)]), primary_key, hash);
+}
+
+
+/**
+ *
+ * Returns the bytes used by the structure that answers the lookups: the
+ * nodes of the trees, the lookup copies if the index is frozen, or the
+ * directory of the file. The words and their postings are not counted,
+ * they are shared by all.
+ *
+ */
+size_t getIndexLookupMemory(Index *index){
+	size_t bytes = 0;
+	int i;
+
+	if (index->file) return (size_t) index->file->header->numWords * sizeof(IndexFileEntry);
+	for (i = 0; i < NSHARDS; i++) {
+		if (!index->frozen)
+			bytes += (size_t) index->shards[i].numNodes * sizeof(Node);
+#if INDEX_LOOKUP == LOOKUP_ART
+		else
+			bytes += index->lookup[i].memory;
+#elif INDEX_LOOKUP == LOOKUP_EYTZINGER
+		else
+			bytes += (size_t) (index->lookup[i].numEntries + 1) * sizeof(EytzingerEntry);
+#endif
+	}
+	return bytes;
+}
+
+
+/**
+ *
+ * Copies the words of the hash table of file idFile to the index. The
+ * entries are first grouped by shard, so each lock is taken only once.
+ * The shards that are busy are left for the end, and each file starts
+ * at a different shard so that concurrent merges do not queue on the
+ * same lock. The index can not be frozen.
+ *
+ */
+void copyHashTableToIndex(HashTable *hashtable, Index *index, int idFile){
+	int start[NSHARDS + 1] = { 0 }, pos[NSHARDS], pending[NSHARDS];
+	HashEntry **order, *entry;
+	int i, j, k, s, numPending = 0;
+	uint64_t since;
+
+	order = malloc(sizeof(HashEntry *) * (hashtable->numItems + 1));
+	if (order == NULL) {
+		printf("insufficient memory (copyHashTableToIndex)\n");
+		exit(1);
+	}
+
+	// agrupem les entrades per shard (comptatge i sumes parcials)
+	for (i = 0; i < hashtable->size; i++) {
+		if (hashtable->entries[i].primary_key == NULL) continue;
+		start[SHARD(hashtable->entries[i].hash) + 1]++;
+	}
+	for (s = 0; s < NSHARDS; s++) {
+		start[s + 1] += start[s];
+		pos[s] = start[s];
+	}
+	for (i = 0; i < hashtable->size; i++) {
+		entry = &(hashtable->entries[i]);
+		if (entry->primary_key == NULL) continue;
+		order[pos[SHARD(entry->hash)]++] = entry;
+	}
+
+	for (k = 0; k < NSHARDS; k++) {
+		s = (idFile + k) % NSHARDS;
+		if (start[s] == start[s + 1]) continue;
+
+		if (PROFILE_TRYLOCK(&(index->locks[s]), &siteShards, &since) != 0) {	//ocupat, el deixem per despres
+			pending[numPending++] = s;
+			continue;
+		}
+		for (j = start[s]; j < start[s + 1]; j++) mergeHashEntry(index, s, order[j], idFile);
+		PROFILE_UNLOCK(&(index->locks[s]), &siteShards, since);
+	}
+
+	for (k = 0; k < numPending; k++) {
+		s = pending[k];
+		PHASE_LOCK_MUTEX(lock, &(index->locks[s]), &siteShards, idFile, 1, since);
+		for (j = start[s]; j < start[s + 1]; j++) mergeHashEntry(index, s, order[j], idFile);
+		PROFILE_UNLOCK(&(index->locks[s]), &siteShards, since);
+	}
+
+	free(order);
+}
+
+
+/**
+ *
+ * Builds the empty shards s with s % numParts == part from the data of
+ * records, which are sorted by key and belong to those shards. The data
+ * are grouped by shard keeping their order, and each shard is built in
+ * linear time with buildTree. If the data are not sorted they are
+ * inserted one by one.
+ *
+ */
+static void buildShards(Index *index, RBData **records, int numRecords, int part, int numParts){
+	int start[NSHARDS + 1] = { 0 }, pos[NSHARDS];
+	RBData **order;
+	int i, s;
+
+	order = malloc(sizeof(RBData *) * (numRecords + 1));
+	if (order == NULL) {
+		printf("insufficient memory (buildShards)\n");
+		exit(1);
+	}
+
+	for (i = 0; i < numRecords; i++) start[SHARD(records[i]->hash) + 1]++;
+	for (s = 0; s < NSHARDS; s++) {
+		start[s + 1] += start[s];
+		pos[s] = start[s];
+	}
+	for (i = 0; i < numRecords; i++) order[pos[SHARD(records[i]->hash)]++] = records[i];
+
+	for (s = part; s < NSHARDS; s += numParts) {
+		if (buildTree(&(index->shards[s]), order + start[s], start[s + 1] - start[s]) != 0)
+			for (i = start[s]; i < start[s + 1]; i++) insertNode(&(index->shards[s]), order[i]);	//no ordenades
+		METRICS_ADD(METRIC_INDEX_WORDS, start[s + 1] - start[s]);
+	}
+
+	free(order);
+}
+
+
+/**
+ *
+ * Copies the words of a run with all the files of the database to an
+ * empty index. The shards are split in numParts parts, and the call only
+ * fills the shards s with s % numParts == part, so numParts threads can
+ * load the run at the same time without taking any lock.
+ *
+ */
+void copyWordRunToIndex(WordRun *run, Index *index, int part, int numParts){
+	RBData *entry, **records;
+	RBTree *tree;
+	int i, s, numRecords = 0;
+
+	records = malloc(sizeof(RBData *) * (run->numEntries + 1));
+	if (records == NULL) {
+		printf("insufficient memory (copyWordRunToIndex)\n");
+		exit(1);
+	}
+
+	for (i = 0; i < run->numEntries; i++) {
+		entry = &(run->entries[i]);
+		s = SHARD(entry->hash);
+		if (s % numParts != part) continue;
+
+		tree = &(index->shards[s]);
+		records[numRecords] = allocRBData(tree, entry->primary_key, strlen(entry->primary_key), entry->hash);
+		records[numRecords]->numFiles = entry->numFiles;
+		copyPostingList(&(records[numRecords]->postings), &(tree->arena), &(entry->postings));
+		sortPostingList(&(records[numRecords]->postings));
+		numRecords++;
+	}
+
+	buildShards(index, records, numRecords, part, numParts);
+	free(records);
+}
+
+
+/**
+ *
+ * Heap of shards ordered by the key of their current node.
+ *
+ */
+static int lessShard(IndexIterator *it, int a, int b){
+	return strcmp(it->data[it->heap[a]]->primary_key, it->data[it->heap[b]]->primary_key) < 0;
+}
+
+static void siftDown(IndexIterator *it, int i){
+	int child, tmp;
+
+	while ((child = 2 * i + 1) < it->numHeap) {
+		if (child + 1 < it->numHeap && lessShard(it, child + 1, child)) child++;
+		if (!lessShard(it, child, i)) break;
+
+		tmp = it->heap[i];
+		it->heap[i] = it->heap[child];
+		it->heap[child] = tmp;
+		i = child;
+	}
+}
+
+
+/**
+ *
+ * Places the iterator before the first word of the index.
+ *
+ */
+void initIndexIterator(IndexIterator *it, Index *index){
+	initIndexRange(it, index, NULL, NULL);
+}
+
+
+/**
+ *
+ * Places the iterator before the first word w of the index with
+ * from <= w < to. A NULL from starts at the first word and a NULL to ends
+ * after the last one. The bounds are only used here, they do not need to
+ * be kept.
+ *
+ */
+void initIndexRange(IndexIterator *it, Index *index, const char *from, const char *to){
+	RBTree *tree;
+	int s, i;
+
+	it->numHeap = 0;
+	it->mapped = NULL;
+#if INDEX_LOOKUP == LOOKUP_ART
+	it->useArt = 0;
+#endif
+	if (from && to && strcmp(from, to) >= 0) return;	//rang buit
+
+	if (index->file) {	//el directori ja esta ordenat
+		it->mapped = index;
+		it->entry = from ? lowerBoundIndexFile(index->file, from) : 0;
+		it->endEntry = to ? lowerBoundIndexFile(index->file, to) : (int) index->file->header->numWords;
+		return;
+	}
+
+	for (s = 0; s < NSHARDS; s++) {
+		tree = &(index->shards[s]);
+		it->current[s] = from ? lowerBoundNode(tree, (char *) from) : firstNode(tree);
+		it->end[s] = to ? lowerBoundNode(tree, (char *) to) : NULL;
+
+		if (it->current[s] != it->end[s]) {
+			it->data[s] = it->current[s]->data;
+			it->heap[it->numHeap++] = s;
+		}
+	}
+	for (i = it->numHeap / 2 - 1; i >= 0; i--) siftDown(it, i);
+}
+
+
+/**
+ *
+ * Places the iterator before the first word that starts with prefix. The
+ * range ends at the first string bigger than all the words with the
+ * prefix: the prefix with its last character incremented.
+ *
+ */
+void initIndexPrefix(IndexIterator *it, Index *index, const char *prefix){
+	char to[MAX_WORDCHR + 2];
+	int len = strlen(prefix);
+
+#if INDEX_LOOKUP == LOOKUP_ART
+	int s, i;
+
+	// l'ART baixa directament al subarbre del prefix de cada shard
+	if (index->frozen && !index->file) {
+		it->numHeap = 0;
+		it->useArt = 1;
+		for (s = 0; s < NSHARDS; s++) {
+			initArtIterator(&(it->art[s]), &(index->lookup[s]), prefix);
+			if ((it->data[s] = nextArt(&(it->art[s]))) != NULL) it->heap[it->numHeap++] = s;
+		}
+		for (i = it->numHeap / 2 - 1; i >= 0; i--) siftDown(it, i);
+		return;
+	}
+#endif
+
+	if (len > MAX_WORDCHR) len = MAX_WORDCHR + 1;	//cap paraula no hi comença
+	memcpy(to, prefix, len);
+	to[len] = '\0';
+
+	// els caracters 0xff no es poden incrementar: es treuen
+	while (len > 0 && (unsigned char) to[len - 1] == 0xff) to[--len] = '\0';
+	if (len == 0) {
+		initIndexRange(it, index, prefix, NULL);
+		return;
+	}
+	to[len - 1]++;
+
+	initIndexRange(it, index, prefix, to);
+}
+
+
+/**
+ *
+ * Returns the next word of the index in alphabetical order, NULL when
+ * all of them have been returned.
+ *
+ */
+RBData *nextIndex(IndexIterator *it){
+	RBData *data;
+	int s;
+
+	if (it->mapped) {	//les entrades malmeses se salten
+		while (it->entry < it->endEntry)
+			if ((data = getMappedData(it->mapped, it->entry++)) != NULL) return data;
+		return NULL;
+	}
+	if (it->numHeap == 0) return NULL;
+
+	s = it->heap[0];
+	data = it->data[s];
+
+#if INDEX_LOOKUP == LOOKUP_ART
+	if (it->useArt) it->data[s] = nextArt(&(it->art[s]));
+	else
+#endif
+	{
+		it->current[s] = nextNode(it->current[s]);
+		it->data[s] = it->current[s] != it->end[s] ? it->current[s]->data : NULL;
+	}
+	if (it->data[s] == NULL) it->heap[0] = it->heap[--it->numHeap];	//shard esgotat
+	siftDown(it, 0);
+
+	return data;
+}
+
+
+/**
+ *
+ * Saves the index into a binary file in the format of index-file.h, which
+ * can also be used in place with openIndexFile.
+ *
+ */
+void saveIndex(Index *index, char *filename){
+	if (writeIndexFile(index, filename) != 0)
+		printf("No s'ha pogut escriure l'index a '%s'\n", filename);
+}
+
+
+/**
+ *
+ * Builds the trees of an index used from its file, and unmaps the file.
+ * The directory is sorted, so the shards are built with buildTree. The
+ * damaged entries are left out.
+ *
+ */
+static void copyIndexFile(Index *index){
+	RBData **records, *data;
+	RBTree *tree;
+	int i, numRecords = 0, numWords = index->file->header->numWords;
+
+	records = malloc(sizeof(RBData *) * (numWords + 1));
+	if (records == NULL) {
+		printf("insufficient memory (copyIndexFile)\n");
+		exit(1);
+	}
+
+	for (i = 0; i < numWords; i++) {
+		if ((data = getMappedData(index, i)) == NULL) continue;
+
+		tree = &(index->shards[SHARD(data->hash)]);
+		records[numRecords] = allocRBData(tree, data->primary_key, index->file->entries[i].keyLen, data->hash);
+		records[numRecords]->numFiles = data->numFiles;
+		copyPostingList(&(records[numRecords]->postings), &(tree->arena), &(data->postings));
+		numRecords++;
+	}
+
+	buildShards(index, records, numRecords, 0, 1);
+
+	free(records);
+	unmapIndex(index);
+}
+
+
+/**
+ *
+ * With verify, loadIndex checks all the index file (data checksum, order
+ * of the keys and every posting list) before using it. Otherwise an entry
+ * is only checked the first time it is used.
+ *
+ */
+void setIndexVerify(int verify){
+	verifyIndexFiles = verify;
+}
+
+
+/**
+ *
+ * Opens an index file to use it in place. Only the header is read: the
+ * index is frozen, and its trees are built if it is thawed.
+ *
+ */
+static Index *loadIndexFile(char *filename){
+	MappedIndex *mi;
+	Index *index;
+
+	mi = malloc(sizeof(MappedIndex));
+	if (mi == NULL) {
+		printf("insufficient memory (loadIndexFile)\n");
+		exit(1);
+	}
+	if (openIndexFile(filename, mi, verifyIndexFiles) != 0) {
+		free(mi);
+		return NULL;
+	}
+
+	index = malloc(sizeof(Index));
+	if (index == NULL) {
+		printf("insufficient memory (loadIndexFile)\n");
+		exit(1);
+	}
+	initIndex(index, mi->header->sizeDb);
+
+	// zeros de calloc: les pagines nomes es fan servir si s'usen les entrades
+	index->views = calloc(mi->header->numWords + 1, sizeof(RBData));
+	if (index->views == NULL) {
+		printf("insufficient memory (loadIndexFile)\n");
+		exit(1);
+	}
+	index->file = mi;
+	index->frozen = 1;	//nomes es consulta fins que es desglaci
+
+	return index;
+}
+
+
+/**
+ *
+ * Loads an index saved with saveIndex, which is used in place (see
+ * loadIndexFile), or a tree file of the earlier versions or of the first
+ * version (see readTreeHeader). In the second case each word goes to the
+ * shard given by its hash value, and the shards are built once all the
+ * records have been read. Returns NULL if the file can not be read.
+ *
+ */
+Index *loadIndex(char *filename){
+	char key[MAX_WORDCHR + 1];
+	int i, s, length, format, sizeDb = 0, numNodes = 0;
+	uint64_t hash;
+	RBData *data, **records;
+	Index *index;
+	FILE *fp;
+
+	if (isIndexFile(filename)) return loadIndexFile(filename);
+
+	fp = fopen(filename, "r");
+	if (!fp) return NULL;
+
+	if ((format = readTreeHeader(fp, &sizeDb, &numNodes)) < 0) {
+		fclose(fp);
+		return NULL;
+	}
+
+	records = malloc(sizeof(RBData *) * numNodes);
+	if (records == NULL) {
+		fclose(fp);
+		return NULL;
+	}
+
+	index = malloc(sizeof(Index));
+	initIndex(index, sizeDb);
+
+	for (i = 0; i < numNodes; i++) {
+		data = NULL;
+
+		length = readRBKey(fp, format, key, &hash);
+		if (length > 0) {
+			s = SHARD(hash);
+			data = allocRBData(&(index->shards[s]), key, length, hash);
+			if (readRBPostings(fp, format, &(index->shards[s]), data) != 0) data = NULL;
+		}
+		if (data == NULL) {	//fitxer malmes
+			fclose(fp);
+			free(records);
+			deleteIndex(index);
+			free(index);
+			return NULL;
+		}
+
+		records[i] = data;
+	}
+	fclose(fp);
+
+	buildShards(index, records, numNodes, 0, 1);
+
+	free(records);
+	return index;
+}
+
+
+/**
+ *
+ * Draws the histogram of word lengths of the whole index.
+ *
+ */
+void drawIndexStats(Index *index){
+	double treeStats[MAX_WORDCHR] = { 0 };
+	int i, numNodes = getIndexNumNodes(index);
+	IndexIterator it;
+	RBData *data;
+
+	initIndexIterator(&it, index);
+	while ((data = nextIndex(&it)) != NULL) treeStats[strlen(data->primary_key) - 1] += 1.0;
+
+	//fem la normalització  de les dades;
+	for (i = 0; i < MAX_WORDCHR; i++) treeStats[i] /= numNodes;
+
+	plotTreeStats(treeStats);
+}
@@ -0,0 +1,138 @@
+/**
+ *
+ * Index header
+ *
+ * Include this file in order to be able to call the
+ * functions available in index.c. We include
+ * here only those information we want to make visible
+ * to other files.
+ *
+ * Igor Dzinka / Vicent Roig, 2014.
+ *
+ */
+#ifndef INDEX_H
+#define INDEX_H
+
+#include <pthread.h>
+#include "red-black-tree.h"
+#include "word-run.h"
+#include "eytzinger.h"
+#include "art.h"
+
+/**
+ *
+ * The global index is split in NSHARDS red-black trees. A word goes to
+ * the shard given by the highest bits of its hash value, so each shard
+ * gets a similar share of the words. Every shard has its own lock and its
+ * own arena, and several threads can merge files at the same time as
+ * long as they work on different shards. NSHARDS has to be a power of 2.
+ *
+ */
+#define NSHARDS_BITS 4
+#define NSHARDS (1 << NSHARDS_BITS)
+
+#define SHARD(hash) ((int) ((hash) >> (64 - NSHARDS_BITS)))
+
+/**
+ *
+ * Structure used for the lookups of a frozen index, chosen at build time
+ * (for instance with -DINDEX_LOOKUP=LOOKUP_ART):
+ *
+ *  LOOKUP_RBTREE     the lookups go to the red-black trees; freezing does nothing
+ *  LOOKUP_EYTZINGER  sorted array in Eytzinger order, see eytzinger.h
+ *  LOOKUP_ART        adaptive radix tree, see art.h
+ *
+ */
+#define LOOKUP_RBTREE    1
+#define LOOKUP_EYTZINGER 2
+#define LOOKUP_ART       3
+
+#ifndef INDEX_LOOKUP
+#define INDEX_LOOKUP LOOKUP_EYTZINGER
+#endif
+
+#if INDEX_LOOKUP == LOOKUP_ART
+typedef Art IndexLookup;
+#else
+typedef Eytzinger IndexLookup;
+#endif
+
+/**
+ *
+ * Once the index is built it can be frozen: every shard gets a read-only
+ * copy for the lookups, and the trees are kept for the ordered walks,
+ * the saves and the statistics. The index has to be thawed before it is
+ * modified again.
+ *
+ * An index loaded from an index file is used in place: it is frozen, the
+ * trees are empty, and the lookups and the walks go to the directory of
+ * the mapped file. The data of an entry is made in views the first time
+ * it is used. Thawing it builds the trees from the file and unmaps it, so
+ * the data returned before is no longer valid.
+ *
+ */
+typedef struct Index_ {
+	RBTree shards[NSHARDS];				/* un arbre per shard */
+	pthread_mutex_t locks[NSHARDS];		/* un lock per shard */
+	int sizeDb;							/* tamany de la base de dades */
+	IndexLookup lookup[NSHARDS];		/* copies per a consultes, si frozen */
+	int frozen;
+	struct MappedIndex_ *file;			/* fitxer que respon les consultes, o NULL */
+	RBData *views;						/* dades de cada entrada del fitxer */
+} Index;
+
+/**
+ *
+ * Iterator that walks the words of the index in alphabetical order, all
+ * of them or only a range. It merges the in-order walks of the shards:
+ * heap keeps the shards ordered by the key of their current word, and
+ * the walk of a shard stops when it reaches its end node (NULL for the
+ * end of the tree). With LOOKUP_ART the walks of a prefix in a frozen
+ * index go down the radix trees instead, and in an index used from its
+ * file the walk goes through the entries of the directory, which is
+ * already sorted. Nothing is copied: the words are returned as they are
+ * found.
+ *
+ */
+typedef struct IndexIterator_ {
+	Node *current[NSHARDS];		/* node actual de cada shard */
+	Node *end[NSHARDS];			/* primer node fora del rang */
+	RBData *data[NSHARDS];		/* paraula actual de cada shard */
+	int heap[NSHARDS];			/* shards amb nodes pendents, el menor primer */
+	int numHeap;
+	Index *mapped;				/* index usat des del fitxer, o NULL */
+	int entry, endEntry;		/* entrades del directori per recorrer */
+#if INDEX_LOOKUP == LOOKUP_ART
+	ArtIterator art[NSHARDS];	/* recorregut de cada shard, si useArt */
+	int useArt;
+#endif
+} IndexIterator;
+
+/**
+ *
+ * Function heders we want to make visible so that they
+ * can be called from any other file.
+ *
+ */
+void initIndex(Index *index, int sizeDb);
+void deleteIndex(Index *index);
+int extendIndex(Index *index, int numFiles);
+void freezeIndex(Index *index);
+void thawIndex(Index *index);
+void sortIndexPostings(Index *index);
+int getIndexNumNodes(Index *index);
+RBData *findIndex(Index *index, char *primary_key);
+RBData *findIndexHash(Index *index, char *primary_key, uint64_t hash);
+size_t getIndexLookupMemory(Index *index);
+void copyHashTableToIndex(HashTable *hashtable, Index *index, int idFile);
+void copyWordRunToIndex(WordRun *run, Index *index, int part, int numParts);
+void initIndexIterator(IndexIterator *it, Index *index);
+void initIndexRange(IndexIterator *it, Index *index, const char *from, const char *to);
+void initIndexPrefix(IndexIterator *it, Index *index, const char *prefix);
+RBData *nextIndex(IndexIterator *it);
+void saveIndex(Index *index, char *filename);
+Index *loadIndex(char *filename);
+void setIndexVerify(int verify);
+void drawIndexStats(Index *index);
+
+#endif
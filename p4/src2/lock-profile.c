@@ -0,0 +1,217 @@
+/**
+ *
+ * Lock profile implementation.
+ *
+ * Counters and histograms of the time the threads wait for the locks of
+ * the build and hold them, per place of the code. They are only gathered
+ * when LOCK_PROFILE is 1, see lock-profile.h.
+ *
+ * Igor Dzinka / Vicent Roig, 2014.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * We include the lock-profile.h header. Note the double
+ * quotes.
+ */
+#include "lock-profile.h"
+
+static const char *bucketNames[LOCKPROF_BUCKETS] = {
+	"<100ns", "<1us", "<10us", "<100us", "<1ms", "<10ms", "<100ms", ">=100ms"
+};
+
+static pthread_mutex_t lockSites = PTHREAD_MUTEX_INITIALIZER;
+static LockSite *allSites = NULL;
+static int numSites = 0;
+
+
+static int getBucket(uint64_t ns){
+	int b = 0;
+
+	ns /= LOCKPROF_MINNS;
+	while (ns > 0 && b < LOCKPROF_BUCKETS - 1) {
+		ns /= 10;
+		b++;
+	}
+	return b;
+}
+
+
+/*
+ * Afegeix site a la llista del resum el primer cop que es fa servir
+ */
+static void registerLockSite(LockSite *site){
+	if (__atomic_load_n(&(site->registered), __ATOMIC_ACQUIRE)) return;
+
+	pthread_mutex_lock(&lockSites);
+	if (!site->registered) {
+		site->next = allSites;
+		allSites = site;
+		numSites++;
+		__atomic_store_n(&(site->registered), 1, __ATOMIC_RELEASE);
+	}
+	pthread_mutex_unlock(&lockSites);
+}
+
+
+static void addAcquisition(LockSite *site, uint64_t wait, int contended){
+	__atomic_add_fetch(&(site->acquisitions), 1, __ATOMIC_RELAXED);
+	if (contended) __atomic_add_fetch(&(site->contended), 1, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&(site->waitNs), wait, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&(site->waitHist[getBucket(wait)]), 1, __ATOMIC_RELAXED);
+}
+
+
+/**
+ *
+ * Locks mutex and adds the wait to site. A lock that is not free at the
+ * first try counts as contended, and so does a retry (retry 1) after a
+ * failed tryLockProfiled, which did not count it. Returns the time when
+ * the lock was taken, to be given to unlockProfiled.
+ *
+ */
+uint64_t lockProfiled(pthread_mutex_t *mutex, LockSite *site, int retry){
+	uint64_t start, now;
+
+	registerLockSite(site);
+
+	if (pthread_mutex_trylock(mutex) == 0) {
+		now = getMetricsTime();
+		addAcquisition(site, 0, retry);
+		return now;
+	}
+
+	start = getMetricsTime();
+	pthread_mutex_lock(mutex);
+	now = getMetricsTime();
+	addAcquisition(site, now - start, 1);
+	return now;
+}
+
+
+/**
+ *
+ * Tries to lock mutex. Returns 0 and the time when it was taken in since
+ * if the lock was free; otherwise the error of pthread_mutex_trylock is
+ * returned and nothing is counted: the contention is counted once, with
+ * the acquisition, when the caller retries with lockProfiled.
+ *
+ */
+int tryLockProfiled(pthread_mutex_t *mutex, LockSite *site, uint64_t *since){
+	int err;
+
+	registerLockSite(site);
+
+	if ((err = pthread_mutex_trylock(mutex)) != 0) return err;
+
+	*since = getMetricsTime();
+	addAcquisition(site, 0, 0);
+	return 0;
+}
+
+
+/**
+ *
+ * Adds the time since the lock was taken to site and unlocks mutex.
+ *
+ */
+void unlockProfiled(pthread_mutex_t *mutex, LockSite *site, uint64_t since){
+	uint64_t hold = getMetricsTime() - since;
+
+	__atomic_add_fetch(&(site->holdNs), hold, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&(site->holdHist[getBucket(hold)]), 1, __ATOMIC_RELAXED);
+	pthread_mutex_unlock(mutex);
+}
+
+
+/**
+ *
+ * Adds a wait of ns nanoseconds that is not for a mutex (a thread that
+ * sleeps on a full queue, or on a barrier). A NULL site is a wait that
+ * does not count.
+ *
+ */
+void addLockSiteWait(LockSite *site, uint64_t ns){
+	if (site == NULL) return;
+	registerLockSite(site);
+	addAcquisition(site, ns, 1);
+}
+
+
+/**
+ *
+ * Sets to zero the statistics of all the sites. It can not be called while
+ * other threads are taking locks.
+ *
+ */
+void resetLockProfile(void){
+	LockSite *site;
+
+	pthread_mutex_lock(&lockSites);
+	for (site = allSites; site != NULL; site = site->next) {
+		site->acquisitions = site->contended = 0;
+		site->waitNs = site->holdNs = 0;
+		memset(site->waitHist, 0, sizeof(site->waitHist));
+		memset(site->holdHist, 0, sizeof(site->holdHist));
+	}
+	pthread_mutex_unlock(&lockSites);
+}
+
+
+static int compareByWait(const void *a, const void *b){
+	const LockSite *sa = *(LockSite * const *) a, *sb = *(LockSite * const *) b;
+
+	if (sa->waitNs != sb->waitNs) return sa->waitNs < sb->waitNs ? 1 : -1;
+	return strcmp(sa->name, sb->name);
+}
+
+
+static void printHistogram(FILE *fp, const char *label, const uint64_t *hist){
+	int b;
+
+	fprintf(fp, "      %-9s", label);
+	for (b = 0; b < LOCKPROF_BUCKETS; b++)
+		fprintf(fp, " %s %llu%s", bucketNames[b], (unsigned long long) hist[b], b < LOCKPROF_BUCKETS - 1 ? " |" : "\n");
+}
+
+
+/**
+ *
+ * Prints the statistics of every site, the one with the longest total
+ * wait first: acquisitions, contended ones, total wait and hold time, and
+ * the histograms of both.
+ *
+ */
+void printLockProfile(FILE *fp){
+	LockSite **sites, *site;
+	int i, n = 0;
+
+	pthread_mutex_lock(&lockSites);
+
+	if ((sites = malloc(sizeof(LockSite *) * (numSites + 1))) == NULL) {
+		printf("insufficient memory (printLockProfile)\n");
+		exit(1);
+	}
+	for (site = allSites; site != NULL; site = site->next)
+		if (site->acquisitions > 0) sites[n++] = site;
+	qsort(sites, n, sizeof(LockSite *), compareByWait);
+
+	fprintf(fp, "▬ Contencio dels locks (el de mes espera primer):\n");
+	for (i = 0; i < n; i++) {
+		site = sites[i];
+		fprintf(fp, "  %s: %llu cops, %llu ocupat (%.1f%%), espera %.3f ms, retencio %.3f ms\n", site->name,
+				(unsigned long long) site->acquisitions, (unsigned long long) site->contended,
+				site->acquisitions ? 100.0 * site->contended / site->acquisitions : 0.0,
+				site->waitNs * 1e-6, site->holdNs * 1e-6);
+		printHistogram(fp, "espera:", site->waitHist);
+		if (site->holdNs > 0) printHistogram(fp, "retencio:", site->holdHist);
+	}
+	if (n == 0) fprintf(fp, "  cap lock utilitzat\n");
+
+	pthread_mutex_unlock(&lockSites);
+	free(sites);
+}
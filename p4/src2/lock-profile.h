@@ -0,0 +1,97 @@
+/**
+ *
+ * Lock profile header
+ *
+ * Include this file in order to be able to call the
+ * functions available in lock-profile.c. We include
+ * here only those information we want to make visible
+ * to other files.
+ *
+ * Igor Dzinka / Vicent Roig, 2014.
+ *
+ */
+#ifndef LOCK_PROFILE_H
+#define LOCK_PROFILE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "metrics.h"
+
+/**
+ *
+ * With LOCK_PROFILE 1 (for instance make CFLAGS="-Wall -Werror -g
+ * -DLOCK_PROFILE=1") the locks of the build go through the wrappers below,
+ * which measure how long the threads wait for them and hold them. With 0,
+ * the default, the macros call pthread directly. Only the locks of src2
+ * are profiled: the lockFilelist and lockThree of src1 are not, their
+ * counterparts are the sites lockFilelist and the shard locks of the
+ * dynamic build (BUILD_DYNAMIC).
+ *
+ */
+#ifndef LOCK_PROFILE
+#define LOCK_PROFILE 0
+#endif
+
+/**
+ *
+ * The times are counted in buckets of powers of 10: below 100 ns, below
+ * 1 us, ..., and from 100 ms on in the last one.
+ *
+ */
+#define LOCKPROF_BUCKETS 8
+#define LOCKPROF_MINNS 100
+
+/**
+ *
+ * Statistics of a place of the code that takes a lock (or a group of
+ * locks, like the shards of the index), or that sleeps waiting for other
+ * threads. Several threads update it at the same time, so all the fields
+ * are changed with atomic adds. A site is declared as a static variable
+ * with LOCK_SITE and is added to the summary the first time it is used.
+ *
+ */
+typedef struct LockSite_ {
+	const char *name;
+	uint64_t acquisitions;				/* vegades que s'ha agafat */
+	uint64_t contended;					/* de les quals estava ocupat */
+	uint64_t waitNs;
+	uint64_t holdNs;
+	uint64_t waitHist[LOCKPROF_BUCKETS];
+	uint64_t holdHist[LOCKPROF_BUCKETS];
+	int registered;
+	struct LockSite_ *next;
+} LockSite;
+
+#define LOCK_SITE(name) { name, 0, 0, 0, 0, { 0 }, { 0 }, 0, NULL }
+
+#if LOCK_PROFILE
+
+#define PROFILE_LOCK(mutex, site, retry) lockProfiled(mutex, site, retry)
+#define PROFILE_TRYLOCK(mutex, site, since) tryLockProfiled(mutex, site, since)
+#define PROFILE_UNLOCK(mutex, site, since) unlockProfiled(mutex, site, since)
+#define PROFILE_WAIT_END(site, t) addLockSiteWait(site, getMetricsTime() - (t))
+
+#else
+
+#define PROFILE_LOCK(mutex, site, retry) ((void) (site), (void) (retry), pthread_mutex_lock(mutex), (uint64_t) 0)
+#define PROFILE_TRYLOCK(mutex, site, since) ((void) (site), *(since) = 0, pthread_mutex_trylock(mutex))
+#define PROFILE_UNLOCK(mutex, site, since) ((void) (site), (void) (since), pthread_mutex_unlock(mutex))
+#define PROFILE_WAIT_END(site, t) ((void) (site))
+
+#endif
+
+/**
+ *
+ * Function heders we want to make visible so that they
+ * can be called from any other file.
+ *
+ */
+uint64_t lockProfiled(pthread_mutex_t *mutex, LockSite *site, int retry);
+int tryLockProfiled(pthread_mutex_t *mutex, LockSite *site, uint64_t *since);
+void unlockProfiled(pthread_mutex_t *mutex, LockSite *site, uint64_t since);
+void addLockSiteWait(LockSite *site, uint64_t ns);
+void resetLockProfile(void);
+void printLockProfile(FILE *fp);
+
+#endif
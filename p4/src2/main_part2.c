@@ -7,54 +7,36 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>  		// per les funcions isalpha, isdigit, ...
 #include <unistd.h>			// per la funció acces()
 #include <pthread.h>
-#include "red-black-tree.h"
+#include <time.h>
+#include <ctype.h>
+#include "index.h"
+#include "query.h"
+#include "search.h"
+#include "builder.h"
+#include "metrics.h"
+#include "trace.h"
+#include "lock-profile.h"
 
-#define MAX_LINECHR 200		// long. maxima per buffer de linia
 #define MAXCHAR 100			// long. maxima per el path del fitxer
-#define NTHREADS 4			// nombre de fils a executar
+#define MAXQUERY 1000		// long. maxima d'una consulta
+#define METRICS_FILE "metrics.json"	// metriques de la construccio (METRICS 1)
 
 #define ERR_MESSAGE__NO_MEM "Memoria insuficient!"
 #define ERR_MESSAGE__FILE "Ha succeit un problema al obrir obrir el fitxer!"
 
 typedef enum { false, true } bool;
 
-pthread_mutex_t lockFilelist;//  = PTHREAD_MUTEX_INITIALIZER;
-pthread_mutex_t mutexP = PTHREAD_MUTEX_INITIALIZER;
-pthread_mutex_t mutexC = PTHREAD_MUTEX_INITIALIZER;
-pthread_cond_t condP, condC;
-
-//int NTHREADS;
-List** buffer;
-int* buffer_index; // necesario para que el consumidor sepa que indice tiene el fichero procesado...
-int w = 0, r = 0;
-int comptador = 0; // nombre d’elements ocupats
-int processats = 0;
-int th_count = 0;
-int indexFile = -1; //indicador del fichero utilizado por threads
-
-struct arg_struct_producer{
-	int* nfiles;
-	char** fileList;
-};
-
-struct arg_struct_consumer{
-	int* nfiles;
-	RBTree* tree;
-};
-
-
-//prototips
-List* processFile(char *filename);
-List* findWords(char *line, List *hashTable);
-RBTree* createTree(char** fileList, int* nfiles);
-char** readDatabase(char *configFile, int* nfiles);
-void processDatabase(char** fileList, RBTree * tree, int *nfiles,  int* tid);
-void* thread_fn(void *arg);
-void* thread_p(void* arg);
-void* thread_c(void* arg);
+int reduceMode = 0;		//1 si l'index es construeix amb l'arbre de merges (opcio -r)
+char *traceFile = NULL;	//fitxer on es desa la traça de cada construccio (opcio -t fitxer)
+
+
+//prototips (la construccio de l'index es a builder.c)
+void searchWords(Index* index, char* filename);
+void rankFiles(SearchEngine* engine, char* query);
+void listPrefix(Index* index, char* prefix);
+void reportMetrics(void);
 
 
 int menu(){
@@ -68,7 +50,11 @@ int menu(){
 	printf("║  2. Emmagatzemar arbre    ║\n");
 	printf("║  3. Carregar arbre        ║\n");
 	printf("║  4. Histograma de l'arbre ║\n");
-	printf("║  5. Sortir                ║\n");
+	printf("║  5. Afegir fitxers        ║\n");
+	printf("║  6. Cercar paraules       ║\n");
+	printf("║  7. Cerca per rellevancia ║\n");
+	printf("║  8. Paraules per prefix   ║\n");
+	printf("║  9. Sortir                ║\n");
 	printf("╚═══════════════════════════╝\n");
 	
 	printf("► Introdueix opció: ");
@@ -85,15 +71,28 @@ int menu(){
  */
 int main(int argc, char **argv){
 	char opcio;
-	RBTree *tree =  NULL;
+	Index *index =  NULL;
 	char *filename = malloc(sizeof(char)*MAXCHAR);
 	char** fileList = NULL;
-	int nfiles, i;
+	char** newFiles;
+	int nfiles, nnew, i, err;
+	char *query = malloc(sizeof(char)*MAXQUERY);
+	SearchEngine engine;
+	int engineReady = 0;	//1 si engine correspon a l'index actual
 	
+	//amb l'opcio -r l'index es construeix amb l'arbre de merges en lloc del productor/consumidor
+	for(i = 1; i < argc; i++){
+		if(strcmp(argv[i], "-r") == 0) reduceMode = 1;
+		else if(strcmp(argv[i], "-t") == 0 && i + 1 < argc) traceFile = argv[++i];
+		else if(strcmp(argv[i], "-c") == 0) setIndexVerify(1);	//comprova tot el fitxer en carregar-lo
+	}
 
-	//NTHREADS = sysconf(_SC_THREAD_THREADS_MAX) * 2;//sysconf(_SC_NPROCESSORS_CONF);//sysconf(_SC_NPROCESSORS_ONLN);
 	do {
 		opcio = menu();
+		if(engineReady && (opcio == '1' || opcio == '3' || opcio == '5')){	//l'index pot canviar
+			deleteSearchEngine(&engine);
+			engineReady = 0;
+		}
 		switch(opcio){
 
 			case '1' :	//crear arbre
@@ -101,20 +100,36 @@ int main(int argc, char **argv){
 				scanf("%s", filename);
 
 				if( access(filename, F_OK )!=-1 ) { // file exists
-					if(tree){	//in case there is alreadey a tree
-						deleteTree(tree);
-						free(tree);
+					resetMetrics();
+					resetLockProfile();
+					if(index){	//in case there is alreadey a tree
+						METRICS_START(release);
+						deleteIndex(index);
+						free(index);
+						METRICS_END(PHASE_FREE, release);
 					}
 					
 					//llegim la base de dades i guardem el contingut a fileList
 					fileList = readDatabase(filename, &nfiles);
-					indexFile = -1;
-					processats = 0;
-					comptador = 0;
-					th_count = 0;
-					tree = createTree(fileList, &nfiles);
+					if(traceFile) startTrace();
+					TRACE_BEGIN("build", -1);
+					if(reduceMode) index = createIndexReduce(fileList, &nfiles);
+					else index = createIndex(fileList, &nfiles);
+					if(index) freezeIndex(index);	//a partir d'ara nomes es consulta
+					TRACE_END("build");
+					if(traceFile){
+						stopTrace();
+						if(saveTrace(traceFile) == 0) printf("\n▬ Traça a '%s'", traceFile);
+						else printf("\n▬ No s'ha pogut escriure la traça a '%s'", traceFile);
+					}
 
-					printf("\nParaules diferents: %d", tree->numNodes);
+					if(index) printf("\nParaules diferents: %d", getIndexNumNodes(index));
+					else printf("\n▬ No s'ha pogut crear l'arbre");
+					reportMetrics();
+#if LOCK_PROFILE
+					printf("\n");
+					printLockProfile(stdout);
+#endif
 					fgetc(stdin);
 
 				} else {
@@ -128,10 +143,13 @@ int main(int argc, char **argv){
 				break;
 
 			case '2' : //emmagatzemar arbre
-				if(tree){
+				if(index){
 					printf("► Nom del fitxer: ");
 					scanf("%s", filename);
-					saveTree(tree, filename);
+					METRICS_START(save);
+					saveIndex(index, filename);
+					METRICS_END(PHASE_SAVE, save);
+					reportMetrics();
 				} else {
 					fflush(stdin);
 					printf("▬ No hi ha cap arbre per emmagatzemar\n");
@@ -144,14 +162,18 @@ int main(int argc, char **argv){
 				printf("► Fitxer de l'arbre: ");
 				scanf("%s", filename);
 				if( access(filename, F_OK )!=-1 ) { // file exists
-					if(tree){	//in case there is alreadey a tree
-						deleteTree(tree);
-						free(tree);
+					if(index){	//in case there is alreadey a tree
+						deleteIndex(index);
+						free(index);
 					}
-					tree = loadTree(filename);
+					METRICS_START(load);
+					index = loadIndex(filename);
+					METRICS_END(PHASE_LOAD, load);
+					if(index) freezeIndex(index);
 
-					if(tree) printf("▬ Arbre Carregat. Paraules diferents: %d", tree->numNodes);
+					if(index) printf("▬ Arbre Carregat. Paraules diferents: %d", getIndexNumNodes(index));
 					else  printf("▬ Error al carregar l'arbre");
+					reportMetrics();
 
 				} else { // file does not exist
 					fflush(stdin);
@@ -163,8 +185,8 @@ int main(int argc, char **argv){
 
 			case '4' :	//Mostrar histogrames
 				//printf("► Opcio mostrar histogrames encara per implementar\n");
-				if(tree){
-					drawTreeStats(tree);
+				if(index){
+					drawIndexStats(index);
 					fflush(stdin);
 					printf("▬ Grafica 'treeHistogram.svg' generada.");
 				}else{
@@ -175,7 +197,92 @@ int main(int argc, char **argv){
 				fgetc(stdin);
 				break;
 
-			case '5' :	//Sortir
+			case '5' :	//Afegir fitxers a un arbre existent
+				if(!index){	//sense arbre a memoria, el carreguem
+					printf("► Fitxer de l'arbre: ");
+					scanf("%s", filename);
+					if( access(filename, F_OK )!=-1 ) index = loadIndex(filename);
+				}
+				if(!index){
+					fflush(stdin);
+					printf("▬ Error. No s'ha trobat arbre carregat.");
+					fgetc(stdin);
+					fgetc(stdin);
+					break;
+				}
+
+				printf("► Fitxer de carrega amb els fitxers nous: ");
+				scanf("%s", filename);
+				if( access(filename, F_OK )!=-1 && (newFiles = readDatabase(filename, &nnew)) != NULL ) {
+					err = addFilesToIndex(index, newFiles, &nnew);
+					for(i = 0; i < nnew; i++) free(newFiles[i]);
+					free(newFiles);
+
+					if(err != 0){	//l'index pot tenir nomes part dels fitxers: no es desa
+						printf("\n▬ No s'han pogut afegir els fitxers. L'arbre es descarta.\n");
+						deleteIndex(index);
+						free(index);
+						index = NULL;
+					} else {
+						freezeIndex(index);
+						printf("\nFitxers: %d. Paraules diferents: %d\n", index->sizeDb, getIndexNumNodes(index));
+
+						//desem el resultat
+						printf("► Nom del fitxer: ");
+						scanf("%s", filename);
+						saveIndex(index, filename);
+					}
+				} else {
+					printf("▬ El fitxer de carrega especificat no es valid.\n");
+				}
+				fgetc(stdin);
+				fgetc(stdin);
+				break;
+
+			case '6' :	//Cercar paraules
+				if(index){
+					printf("► Fitxer amb les paraules: ");
+					scanf("%s", filename);
+					searchWords(index, filename);
+				}else{
+					fflush(stdin);
+					printf("▬ Error. No s'ha trobat arbre carregat.");
+				}
+				fgetc(stdin);
+				fgetc(stdin);
+				break;
+
+			case '7' :	//Cerca booleana i per rellevancia
+				if(index){
+					if(!engineReady){
+						initSearchEngine(&engine, index, RANK_BM25);
+						engineReady = 1;
+					}
+					printf("► Consulta (AND, OR, NOT): ");
+					scanf(" %999[^\n]", query);
+					rankFiles(&engine, query);
+				}else{
+					fflush(stdin);
+					printf("▬ Error. No s'ha trobat arbre carregat.");
+				}
+				fgetc(stdin);
+				fgetc(stdin);
+				break;
+
+			case '8' :	//Paraules que comencen per un prefix
+				if(index){
+					printf("► Prefix: ");
+					scanf("%s", filename);
+					listPrefix(index, filename);
+				}else{
+					fflush(stdin);
+					printf("▬ Error. No s'ha trobat arbre carregat.");
+				}
+				fgetc(stdin);
+				fgetc(stdin);
+				break;
+
+			case '9' :	//Sortir
 				printf("Exit\n");
 				break;
 
@@ -184,14 +291,16 @@ int main(int argc, char **argv){
 				printf("\n▬ Opció introduida no es valida. (pulsa tecla per continuar)\n");
 				fgetc(stdin);
 		}
-	} while(opcio!= '5');	
+	} while(opcio!= '9');	
 
 
-	if(tree){
-		deleteTree(tree);
-		free(tree);
+	if(index){
+		deleteIndex(index);
+		free(index);
 	}
+	if(engineReady) deleteSearchEngine(&engine);
 	if(filename) free(filename);
+	free(query);
 	if(fileList){
 		for(i = 0;i< nfiles;i++) free(fileList[i]);
 		free(fileList);
@@ -201,334 +310,109 @@ int main(int argc, char **argv){
 }
 
 
-RBTree* createTree(char** fileList, int* nfiles){
-	int i, err;
-	pthread_t tid[NTHREADS+1];
-
-    /* Buffering allocation */
-	if ((buffer = (List**) malloc((NTHREADS)*sizeof( List*))) == NULL) return NULL; // reserva de memoria per el buffer
-	if ((buffer_index = (int*) malloc((NTHREADS)*sizeof( int))) == NULL) return NULL; // reserva de memoria per el buffer dels index
-
-	RBTree *tree = malloc(sizeof(RBTree));
-    /* Init tree */
-	initTree(tree);
-	tree->sizeDb = *nfiles;
-
-    struct  arg_struct_producer args_p;
-    	args_p.nfiles = nfiles;
-    	args_p.fileList = fileList;
-	
-	struct  arg_struct_consumer args_c;
-    	args_c.nfiles = nfiles;
-		args_c.tree = tree;
-
-    if (pthread_mutex_init(&lockFilelist, NULL) != 0){
-	    printf("\n lockFilelist init failed\n");
-	    return NULL;
-    }
-
-    pthread_cond_init(&condP, NULL);
-    pthread_cond_init(&condC, NULL);
-
-    //creació de thread consumidor
-    if( (err = pthread_create(&tid[0], NULL, &thread_c, (void *) &args_c)) != 0){
-    		printf("\ncan't create thread :[%s]", strerror(err));
-    		return NULL;
-    }
-
-	//creaació dels threads productor
-    for(i=1; i <= NTHREADS; i++){
-    	if( (err = pthread_create(&tid[i], NULL, &thread_p, (void *) &args_p)) != 0){
-    		printf("\ncan't create thread :[%s]", strerror(err));
-    		return NULL;
-    	}
-    }
-
-    /* El fil principal es quedarà esperant que els fils creats finalitzin la creacio de l’arbre */
-    for(i=0; i <= NTHREADS; i++){
-    	pthread_join(tid[i], NULL);
-    }
-    
-
-    pthread_mutex_destroy(&lockFilelist);
-	free(buffer);
-	free(buffer_index);
-
-    return args_c.tree;
-}
-
-
 /**
- * Funció per llegir el fitxer de configuració i guardar el seu contingut a una llista que es passa per referencia
+ *
+ * With METRICS 1, writes the metrics gathered since the last "Crear
+ * arbre" to METRICS_FILE.
+ *
  */
-char** readDatabase(char *configFile, int* nfiles){
-	FILE *fp;
-	int i;
-	char *pname;
-	char** fileList = NULL;
-	char line[MAX_LINECHR], path[MAXCHAR], file[MAXCHAR];
-	pname = NULL;
-	
-	fp = fopen(configFile, "r");
-	if (!fp) {
-		printf("No s'ha pogut obrir el fitxer '%s'\n", configFile);
-		return NULL;
-	}
-
-	fgets(line, MAXCHAR, fp);	//llegim la primera linia amb el nombre de arxius a processar
-	*nfiles = atoi(line);		//fent servir funcio atoi com indica el manual de la practica
-	printf("nfiles = %d\n",*nfiles);
-	if ( *nfiles < 1) {
-		printf("El nombre d'arxius al fitxer '%s' no es correcte.\n", configFile);
-		fclose(fp);
-		return NULL;
-	}
-
-	//reservem memoria per a la llista de fitxers
-	if ((fileList = (char**) malloc((*nfiles)*sizeof( char*))) == NULL) return NULL; 
-	
-
-	/* Extract pathname: aixo sera util per poder referenciar .cfg amb paths relatius */
-	pname = strrchr(configFile, '/'); 	//trobem la ultima aparicio del caracter '/' al nom de la base de dades
-	if (pname == NULL)					//si no hi ha cap '/' llavors inicialitzem un string buit
-		path[0] = '\0';
-	else {
-		strcpy(path, configFile);		//copiem la ruta de la base de dades
-		path[pname-configFile+1] = '\0';//treiem a la ruta el nom de la base de dades per quedar-nos nomes amb la ruta a la carpeta on es troba
-	}
-	
-	for(i=0; i < (*nfiles); i++) {
-		// LLegim la linia 
-		fgets(line, MAX_LINECHR, fp);
-		line[strlen(line)-1] = '\0';	//fgets inclou el \n, per tant el substituim per el EOS.
-
-		// Generem la ruta del fitxer a llegir
-		strcpy(file, path);		//copiem la ruta fin a la carpeta (calculada abans)
-		strcat(file, line);		//concatenem el nom  del fitxer i  aixi obtenim la ruta absoluta
-		
-		//reservem tant espai com es requereix per guardar la ruta
-		if ((fileList[i] = malloc( sizeof(char)*(strlen(file)+1) )) == NULL) return NULL;
-
-		//guardem  la ruta a la llista de fitxers
-		strcpy(fileList[i], file);
-		//printf("IT%d -- STRCPY RESULT [%s]->[%s]\n", i, file, fileList[i]);
-	}
-	
-	fclose(fp);	//tanquem el fitxer de base de dades
-	return fileList;
+void reportMetrics(void){
+#if METRICS
+	if (saveMetrics(METRICS_FILE) == 0) printf("\n▬ Metriques a '%s'", METRICS_FILE);
+	else printf("\n▬ No s'han pogut escriure les metriques a '%s'", METRICS_FILE);
+#endif
 }
 
 
 /**
  *
- * Donat un fitxer extreu d'ell totes les paraules i les guarda a una hashTable
- * Retorna la hashTable amb les paraules
+ * Looks for all the words of a file in the index with one batch, and
+ * prints in which files each word appears and how many times, followed
+ * by the time of the lookup in queries per second.
  *
  */
-List* processFile(char* filename){
-	
-	List *hashTable;
-	FILE *fp;
-
-	fp = fopen(filename, "r");
-	if (!fp) {
-		printf("\nNo s'ha pogut obrir el fitxer '%s'", filename);
-		return NULL ;
+void searchWords(Index* index, char* filename){
+	struct timespec start, end;
+	PostingIterator it;
+	Query *queries;
+	int i, numQueries, found = 0;
+	double seconds;
+
+	if ((queries = readQueryFile(filename, &numQueries)) == NULL) {
+		printf("▬ No s'ha pogut llegir el fitxer '%s'\n", filename);
+		return;
 	}
 
-	char *line = malloc(sizeof(char)*MAX_LINECHR);
-	if(line == NULL){
-		printf("%s", ERR_MESSAGE__NO_MEM);
-		return NULL;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	lookupWords(index, queries, numQueries);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+
+	for (i = 0; i < numQueries; i++) {
+		if (queries[i].data == NULL) {
+			printf("%s: no hi es\n", queries[i].word);
+			continue;
+		}
+		found++;
+
+		printf("%s: %d fitxers ->", queries[i].word, queries[i].data->numFiles);
+		initPostingIterator(&it, &(queries[i].data->postings));
+		while (nextPosting(&it)) printf(" %d:%d", it.fileId, it.numTimes);
+		printf("\n");
 	}
 
-	hashTable = allocHashTable(HASHSIZE);
-	// extreiem mitjançant la funcio findWords totes les paraules del fitxer linia a linia
-	while( fgets(line, MAX_LINECHR, fp)!=NULL ) hashTable = findWords(line, hashTable);
+	printf("▬ %d consultes (%d trobades) en %.3f ms: %.0f consultes/s\n", numQueries, found,
+			seconds * 1e3, seconds > 0 ? numQueries / seconds : 0.0);
 
-	fclose(fp);
-	free(line);
-	return hashTable;
+	freeQueries(queries, numQueries);
 }
 
 
 /**
- * Donada qualsevol cadena de caràcters rebuda per referència, cerca
- * paraules seguint els criteris especificats i les guarda a una hashTable
- * */
-List * findWords(char *line, List *hashTable){
-	//printf("Entrant a findWords per tractar %s.\n",line);
-	char c;
-	char *word, *word_copy;
-	int i, j, k, valor_hash;
-	ListData *listData;
-	
-	word = malloc( sizeof(char) * MAX_WORDCHR ); /* buffer per construir les paraules */
-	if(word == NULL){
-		printf(ERR_MESSAGE__NO_MEM);
-		exit(5);
-	}
+ *
+ * Prints the SEARCH_TOPK files that best answer the query, with their
+ * score, and the time of the search.
+ *
+ */
+void rankFiles(SearchEngine* engine, char* query){
+	SearchHit hits[SEARCH_TOPK];
+	struct timespec start, end;
+	int i, numHits;
 
-	bool validate = true;
-	c = i = j = 0;
-	while ( i < MAX_LINECHR && c!='\n' ){
-		c = line[i];
-
-		if( isspace(c) || (ispunct(c) && c!='\'') ) { /* determina el final de paraula */
-			// comprovem que no es tracta de una paraula buida -> tenim 1 o més caràcters al buffer
-			if(j > 0){
-				word[j]='\0'; /* al construir manualment la paraula, és important no oblidar introduir el final de cadena */
-				
-				//paraula valida; la copiem a la estructura local
-				if(validate){
-					word_copy = malloc(sizeof(char) * (strlen(word)+1));
-					if(word_copy == NULL){
-						printf(ERR_MESSAGE__NO_MEM);
-						exit(4);
-					}
-					
-					
-					for(k = 0; k < strlen(word)+1; k++)	word_copy[k] = word[k]; //copiem la paraula al auxiliar word_copy
-					
-					valor_hash = getHashValue(word_copy);						//obtenim el seu valor hash
-					listData = findList(&(hashTable[valor_hash]), word_copy);	//mirem si la paraula ja esta a la llista
-					if (listData != NULL) {
-						// si la trobem incrementem el numero de cops de aparicio
-						listData->numTimes++;
-						free(word_copy);	//en cas de no enllaçar el buffer auxiliar a listData el tenim que alliberar ara.
-					} else {
-						// si la paraula no esta, creem un nou node amb paraula com a clau i numTimes a 1.
-						listData = malloc(sizeof(ListData));
-						listData->primary_key = word_copy;
-						listData->numTimes = 1;
-						insertList(&(hashTable[valor_hash]), listData); //L'inserim a la llista
-					}
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	numHits = searchIndex(engine, query, hits, SEARCH_TOPK);
+	clock_gettime(CLOCK_MONOTONIC, &end);
 
-				} //fi if validate
-				
-				validate = true;
-				j = 0;	//reset buffer
-			}
-			
-		} else { // el caracter no es tracta de un final de paraula.
-			if(iscntrl(c) || !isascii(c) || isdigit(c)) validate = false;
-			else {
-
-				if(isupper(c)) c = tolower(c);
-				
-				// abans d'afegir cada un dels caracters contralem la mida del buffer
-				if(j<MAX_WORDCHR){
-					word[j] = c;	//caracter afegit al buffer
-					j++;
-				} else {
-					j = 0;
-				}
-			}
-		}
-		
-		i++;
-	}
+	if (numHits == 0) printf("▬ Cap fitxer compleix la consulta\n");
+	for (i = 0; i < numHits; i++) printf("%2d. fitxer %d (%.4f)\n", i + 1, hits[i].fileId, hits[i].score);
 
-	free(word);
-	return hashTable;
+	printf("▬ Cerca en %.3f ms\n", (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) * 1e-6);
 }
 
 
-
-/* * * * * * * * * * * * * * * * * *
- *   
- *	Consumer/Producer functions
+/**
  *
- * * * * * * * * * * * * * * * * * */
-
-void consume(RBTree * tree, int *nfiles ){
-	
-	List* hashTable = buffer[r];
-	int index = buffer_index[r];
-	
-	if (hashTable) { 				// si s'ha pogut crear l'estructura local, copiem el seu contingut a l'estructura global
-		//printf("\n\t\t[thread] > SIZE_T: %d [BEFORE] del fitxer %d", tree->numNodes, index);
-		copyHashTableToTree(hashTable, tree, index, nfiles);	//copiant el contingut al arbre
-		printf("\n\t\t[thread] > SIZE_T: %d [AFTER] del fitxer %d", tree->numNodes, index);
-
-		//printf("paraules desades al arbre global: %d ", tree->numNodes);
-		freeHashTable(hashTable, HASHSIZE);
+ * Prints the words of the index that start with prefix, in alphabetical
+ * order, with the files where they appear. The words are printed as the
+ * iterator finds them.
+ *
+ */
+void listPrefix(Index* index, char* prefix){
+	IndexIterator it;
+	PostingIterator pit;
+	RBData *data;
+	int i, numWords = 0;
+
+	for (i = 0; prefix[i]; i++) prefix[i] = tolower((unsigned char) prefix[i]);
+
+	initIndexPrefix(&it, index, prefix);
+	while ((data = nextIndex(&it)) != NULL) {
+		printf("%s: %d fitxers ->", data->primary_key, data->numFiles);
+		initPostingIterator(&pit, &(data->postings));
+		while (nextPosting(&pit)) printf(" %d:%d", pit.fileId, pit.numTimes);
+		printf("\n");
+		numWords++;
 	}
-}
-
 
-void* thread_p(void* arg){
-	struct arg_struct_producer *args = (struct arg_struct_producer *) arg;
-
-	char* filename;
-	int localIndex;
-	List* hashTable;	//la taula hash
-	
-	//bloqueo del acceso a la lista de ficheros
-	pthread_mutex_lock(&lockFilelist);
-	indexFile++;
-	localIndex = indexFile;
-	pthread_mutex_unlock(&lockFilelist);
-	
-	
-	while(localIndex < *args->nfiles){
-		
-		if(localIndex >= *args->nfiles){
-			buffer[w] = NULL;		//copia la estructura local al buffer
-			buffer_index[w] = localIndex;
-			return NULL;
-		}
-
-		// Process file
-		filename = args->fileList[localIndex];
-		printf("\n\t[thread ] > Entrant a processFile per tractar el fitxer %s", filename);
-		hashTable = processFile(filename);	// processament del fitxer i assignacio de resultats a estructura local
-		
-		
-
-		pthread_mutex_lock(&mutexP);
-		while (comptador == NTHREADS) {
-			pthread_cond_wait(&condP, &mutexP);
-		}
-
-		buffer[w] = hashTable;		//copia la estructura local al buffer
-		buffer_index[w] = localIndex;	
-		
-		w = (w+1)%NTHREADS;
-		comptador++;
-		
-		//bloqueo del acceso a la lista de ficheros
-		pthread_mutex_lock(&lockFilelist);
-		indexFile++;
-		localIndex = indexFile;
-		pthread_mutex_unlock(&lockFilelist);
-
-		pthread_cond_signal(&condC);
-		pthread_mutex_unlock(&mutexP);
-	}
-	return NULL;
+	printf("▬ %d paraules comencen per '%s'\n", numWords, prefix);
 }
-
-
-void* thread_c(void* arg){
-	struct arg_struct_consumer *args = (struct arg_struct_consumer *) arg;
-	while(processats != *args->nfiles){
-
-		pthread_mutex_lock(&mutexC);
-		while (comptador == 0) {
-			//printf("\n**** CONSUMIDOR Esperant...");
-			pthread_cond_wait(&condC, &mutexC);
-		}
-
-		//printf("\n\t-> Consuming...");
-		consume( args->tree, args->nfiles);
-		r = (r+1)%NTHREADS;
-		comptador--;
-		processats++;
-
-		pthread_cond_broadcast(&condP);
-		pthread_mutex_unlock(&mutexC);
-		
-	}
-	return NULL;
-}
\ No newline at end of file
@@ -0,0 +1,189 @@
+/**
+ *
+ * Metrics implementation.
+ *
+ * Counters and timers of the phases of the build, kept per thread and
+ * written as JSON. They are only updated when METRICS is 1, see
+ * metrics.h.
+ *
+ * Igor Dzinka / Vicent Roig, 2014.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+/**
+ * We include the metrics.h header. Note the double
+ * quotes.
+ */
+#include "metrics.h"
+
+static const char *phaseNames[METRICS_NUMPHASES] = {
+	"read", "tokenize", "queue_wait", "lock_wait", "barrier_wait", "merge", "save", "load", "free"
+};
+
+static const char *counterNames[METRICS_NUMCOUNTERS] = {
+	"bytes", "words", "file_words", "index_words", "hash_probes", "tree_comparisons"
+};
+
+static pthread_mutex_t lockMetrics = PTHREAD_MUTEX_INITIALIZER;
+static ThreadMetrics *allMetrics = NULL;	//les de tots els fils, la mes nova primer
+static int numMetrics = 0;
+static int generation = 0;					//canvia a cada resetMetrics
+
+static __thread ThreadMetrics *localMetrics = NULL;
+static __thread int localGeneration;
+
+
+/**
+ *
+ * Returns the metrics of the calling thread. The first call of a thread
+ * (or the first one after resetMetrics) allocates them and adds them to
+ * the list.
+ *
+ */
+ThreadMetrics *getThreadMetrics(void){
+	ThreadMetrics *m = localMetrics;
+
+	if (m != NULL && localGeneration == generation) return m;
+
+	if ((m = calloc(1, sizeof(ThreadMetrics))) == NULL) {
+		printf("insufficient memory (getThreadMetrics)\n");
+		exit(1);
+	}
+
+	pthread_mutex_lock(&lockMetrics);
+	m->next = allMetrics;
+	allMetrics = m;
+	numMetrics++;
+	localGeneration = generation;
+	pthread_mutex_unlock(&lockMetrics);
+
+	localMetrics = m;
+	return m;
+}
+
+
+/**
+ *
+ * Returns a monotonic time in nanoseconds. It is the clock of the
+ * metrics, the trace and the lock profile.
+ *
+ */
+uint64_t getMetricsTime(void){
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+
+/**
+ *
+ * Adds ns nanoseconds to a phase of the calling thread.
+ *
+ */
+void addMetricsPhase(MetricsPhase phase, uint64_t ns){
+	ThreadMetrics *m = getThreadMetrics();
+
+	m->phaseNs[phase] += ns;
+	m->phaseCount[phase]++;
+}
+
+
+/**
+ *
+ * Forgets the metrics of all the threads. It can not be called while
+ * other threads are updating theirs.
+ *
+ */
+void resetMetrics(void){
+	ThreadMetrics *m;
+
+	pthread_mutex_lock(&lockMetrics);
+	while ((m = allMetrics) != NULL) {
+		allMetrics = m->next;
+		free(m);
+	}
+	numMetrics = 0;
+	generation++;
+	pthread_mutex_unlock(&lockMetrics);
+}
+
+
+static void writeThreadMetrics(FILE *fp, const ThreadMetrics *m, const char *indent){
+	int i;
+
+	fprintf(fp, "{\n%s  \"phases\": {", indent);
+	for (i = 0; i < METRICS_NUMPHASES; i++)
+		fprintf(fp, "%s\n%s    \"%s\": {\"ms\": %.3f, \"count\": %llu}", i ? "," : "", indent, phaseNames[i],
+				m->phaseNs[i] * 1e-6, (unsigned long long) m->phaseCount[i]);
+
+	fprintf(fp, "\n%s  },\n%s  \"counters\": {", indent, indent);
+	for (i = 0; i < METRICS_NUMCOUNTERS; i++)
+		fprintf(fp, "%s\n%s    \"%s\": %llu", i ? "," : "", indent, counterNames[i],
+				(unsigned long long) m->counters[i]);
+
+	fprintf(fp, "\n%s  }\n%s}", indent, indent);
+}
+
+
+/**
+ *
+ * Writes the metrics as a JSON object: the sum of all the threads in
+ * "total" and the metrics of every thread, in the order they started, in
+ * "threads".
+ *
+ */
+void writeMetrics(FILE *fp){
+	ThreadMetrics total, **threads, *m;
+	int i, j, n;
+
+	pthread_mutex_lock(&lockMetrics);
+
+	memset(&total, 0, sizeof(total));
+	if ((threads = malloc(sizeof(ThreadMetrics *) * (numMetrics + 1))) == NULL) {
+		printf("insufficient memory (writeMetrics)\n");
+		exit(1);
+	}
+
+	n = numMetrics;
+	for (m = allMetrics, i = n - 1; m != NULL; m = m->next, i--) {
+		threads[i] = m;
+		for (j = 0; j < METRICS_NUMPHASES; j++) {
+			total.phaseNs[j] += m->phaseNs[j];
+			total.phaseCount[j] += m->phaseCount[j];
+		}
+		for (j = 0; j < METRICS_NUMCOUNTERS; j++) total.counters[j] += m->counters[j];
+	}
+
+	fprintf(fp, "{\n  \"enabled\": %s,\n  \"numThreads\": %d,\n  \"total\": ", METRICS ? "true" : "false", n);
+	writeThreadMetrics(fp, &total, "  ");
+	fprintf(fp, ",\n  \"threads\": [");
+	for (i = 0; i < n; i++) {
+		fprintf(fp, "%s\n    ", i ? "," : "");
+		writeThreadMetrics(fp, threads[i], "    ");
+	}
+	fprintf(fp, "\n  ]\n}\n");
+
+	pthread_mutex_unlock(&lockMetrics);
+	free(threads);
+}
+
+
+/**
+ *
+ * Writes the metrics to the file filename. Returns 0 on success.
+ *
+ */
+int saveMetrics(char *filename){
+	FILE *fp;
+
+	if ((fp = fopen(filename, "w")) == NULL) return -1;
+	writeMetrics(fp);
+	return fclose(fp) == 0 ? 0 : -1;
+}
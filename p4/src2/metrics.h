@@ -0,0 +1,106 @@
+/**
+ *
+ * Metrics header
+ *
+ * Include this file in order to be able to call the
+ * functions available in metrics.c. We include
+ * here only those information we want to make visible
+ * to other files.
+ *
+ * Igor Dzinka / Vicent Roig, 2014.
+ *
+ */
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+/**
+ *
+ * With METRICS 1 (for instance make CFLAGS="-Wall -Werror -g -DMETRICS=1")
+ * the hot paths count their work and time their phases. With 0, the
+ * default, the macros below are empty and nothing is measured.
+ *
+ */
+#ifndef METRICS
+#define METRICS 0
+#endif
+
+/**
+ *
+ * Timed phases. The time waiting for a lock of the index (PHASE_LOCK) is
+ * also part of the merge that waits, and the local hash table is filled
+ * while the text is scanned, so its inserts are part of PHASE_TOKENIZE
+ * (METRIC_PROBES tells how much they cost).
+ *
+ */
+typedef enum {
+	PHASE_READ,			/* obrir i mapejar el fitxer */
+	PHASE_TOKENIZE,		/* tokenitzar i omplir la taula local */
+	PHASE_QUEUE,		/* esperant a la cua, plena o buida */
+	PHASE_LOCK,			/* esperant el lock d'un shard */
+	PHASE_BARRIER,		/* esperant els altres fils a la barrera */
+	PHASE_MERGE,		/* merge a l'index */
+	PHASE_SAVE,
+	PHASE_LOAD,
+	PHASE_FREE,			/* alliberar taules, fitxers i index */
+	METRICS_NUMPHASES
+} MetricsPhase;
+
+/**
+ *
+ * Counters.
+ *
+ */
+typedef enum {
+	METRIC_BYTES,			/* bytes dels fitxers llegits */
+	METRIC_WORDS,			/* paraules trobades */
+	METRIC_FILE_WORDS,		/* paraules diferents de cada fitxer, sumades */
+	METRIC_INDEX_WORDS,		/* paraules noves de l'index */
+	METRIC_PROBES,			/* entrades mirades a les taules hash locals */
+	METRIC_COMPARISONS,		/* nodes visitats als arbres */
+	METRICS_NUMCOUNTERS
+} MetricsCounter;
+
+/**
+ *
+ * Metrics of one thread. Every thread writes only its own, without locks;
+ * they are added up when they are written.
+ *
+ */
+typedef struct ThreadMetrics_ {
+	uint64_t phaseNs[METRICS_NUMPHASES];		/* temps de cada fase */
+	uint64_t phaseCount[METRICS_NUMPHASES];		/* vegades que s'ha fet cada fase */
+	uint64_t counters[METRICS_NUMCOUNTERS];
+	struct ThreadMetrics_ *next;
+} ThreadMetrics;
+
+#if METRICS
+
+#define METRICS_START(t) uint64_t t = getMetricsTime()
+#define METRICS_END(phase, t) addMetricsPhase(phase, getMetricsTime() - (t))
+#define METRICS_ADD(counter, n) (getThreadMetrics()->counters[counter] += (n))
+
+#else
+
+#define METRICS_START(t)
+#define METRICS_END(phase, t)
+#define METRICS_ADD(counter, n)
+
+#endif
+
+/**
+ *
+ * Function heders we want to make visible so that they
+ * can be called from any other file.
+ *
+ */
+ThreadMetrics *getThreadMetrics(void);
+uint64_t getMetricsTime(void);
+void addMetricsPhase(MetricsPhase phase, uint64_t ns);
+void resetMetrics(void);
+void writeMetrics(FILE *fp);
+int saveMetrics(char *filename);
+
+#endif
@@ -0,0 +1,52 @@
+/**
+ *
+ * Phase header
+ *
+ * Macros that measure a phase of the build once and give the time to
+ * the metrics, the trace and the lock profile together, instead of
+ * timing it with the macros of each of them. They only use those three
+ * headers, so there is no phase.c.
+ *
+ * Igor Dzinka / Vicent Roig, 2014.
+ *
+ */
+#ifndef PHASE_H
+#define PHASE_H
+
+#include "metrics.h"
+#include "trace.h"
+#include "lock-profile.h"
+
+/**
+ *
+ * PHASE_BEGIN opens a span name (arg is a file id, or -1) and keeps the
+ * start time in t; PHASE_END adds the time to the metrics phase and
+ * closes the span. PHASE_WAIT_END is the same for a wait, which is also
+ * added to site (if it is not NULL). The time is only read when METRICS
+ * or LOCK_PROFILE are 1. PHASE_BEGIN declares t, so it has to be in the
+ * same block as its PHASE_END; the other macros are single statements.
+ *
+ */
+#if METRICS || LOCK_PROFILE
+#define PHASE_BEGIN(t, name, arg) TRACE_BEGIN(name, arg); uint64_t t __attribute__((unused)) = getMetricsTime()
+#else
+#define PHASE_BEGIN(t, name, arg) TRACE_BEGIN(name, arg)
+#endif
+
+#define PHASE_END(t, phase, name) do { METRICS_END(phase, t); TRACE_END(name); } while (0)
+#define PHASE_WAIT_END(t, phase, site, name) do { METRICS_END(phase, t); PROFILE_WAIT_END(site, t); TRACE_END(name); } while (0)
+
+/**
+ *
+ * Locks mutex as the phase PHASE_LOCK, with the span "lock_wait", and
+ * leaves in since the time to give to PROFILE_UNLOCK. retry is 1 after a
+ * failed PROFILE_TRYLOCK of the same lock (see lockProfiled).
+ *
+ */
+#define PHASE_LOCK_MUTEX(t, mutex, site, arg, retry, since) do { \
+	PHASE_BEGIN(t, "lock_wait", arg); \
+	since = PROFILE_LOCK(mutex, site, retry); \
+	PHASE_END(t, PHASE_LOCK, "lock_wait"); \
+} while (0)
+
+#endif
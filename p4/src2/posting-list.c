@@ -0,0 +1,286 @@
+/**
+ *
+ * Posting list implementation.
+ *
+ * Sparse and compressed replacement of the numTimes array of each word:
+ * a word that appears in k files of the database costs a few bytes per
+ * file where it appears, instead of one int per file of the database.
+ *
+ * Igor Dzinka / Vicent Roig, 2014.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * We include the posting-list.h header. Note the double
+ * quotes.
+ */
+#include "posting-list.h"
+
+
+/**
+ *
+ * Writes value as a varint: 7 bits per byte, lowest first, with the high
+ * bit set in all the bytes but the last one. Returns the number of bytes.
+ *
+ */
+int putVarint(unsigned char *p, unsigned int value){
+	int n = 0;
+
+	while (value >= 0x80) {
+		p[n++] = (value & 0x7f) | 0x80;
+		value >>= 7;
+	}
+	p[n++] = value;
+	return n;
+}
+
+
+/**
+ *
+ * Reads a varint written by putVarint. Returns the number of bytes read.
+ *
+ */
+int getVarint(const unsigned char *p, unsigned int *value){
+	unsigned int v = 0;
+	int n = 0, shift = 0;
+
+	do {
+		v |= (unsigned int) (p[n] & 0x7f) << shift;
+		shift += 7;
+	} while (p[n++] & 0x80);
+
+	*value = v;
+	return n;
+}
+
+
+/**
+ *
+ * Checks the len bytes of a posting list read from a file: every varint
+ * ends inside the list and fits in an int, the fileIds grow and are below
+ * sizeDb, and every numTimes is at least 1. Stores the number of postings
+ * and the last fileId. Returns 0, or -1 if the list is damaged.
+ *
+ */
+int checkPostingList(const unsigned char *bytes, int len, int sizeDb, int *numFiles, int *lastFile){
+	unsigned int value[2];
+	long long fileId = -1;
+	int k, n = 0, shift, off = 0;
+
+	if (len < 2) return -1;
+	while (off < len) {
+		for (k = 0; k < 2; k++) {
+			value[k] = 0;
+			shift = 0;
+			do {
+				if (off >= len || shift > 28) return -1;	//varint tallat o massa llarg
+				value[k] |= (unsigned int) (bytes[off] & 0x7f) << shift;
+				shift += 7;
+			} while (bytes[off++] & 0x80);
+		}
+		fileId += (long long) value[0] + 1;
+		if (fileId >= sizeDb || value[1] < 1 || value[1] > 0x7fffffff) return -1;
+		n++;
+	}
+
+	*numFiles = n;
+	*lastFile = (int) fileId;
+	return 0;
+}
+
+
+/**
+ *
+ * Initialize an empty posting list. No memory is used until the first
+ * posting is added.
+ *
+ */
+void initPostingList(PostingList *list){
+	list->bytes = NULL;
+	list->len = 0;
+	list->cap = 0;
+	list->sorted = 0;
+	list->lastFile = -1;
+}
+
+
+/**
+ *
+ * Makes room for extra more bytes. The old buffer stays in the arena
+ * until the arena is deleted; doubling the size keeps this waste below
+ * the size of the list.
+ *
+ */
+static void reservePostings(PostingList *list, Arena *arena, int extra){
+	unsigned char *bytes;
+	int cap;
+
+	if (list->len + extra <= list->cap) return;
+
+	cap = list->cap ? list->cap * 2 : 16;
+	while (cap < list->len + extra) cap *= 2;
+
+	bytes = allocArena(arena, cap);
+	if (list->len > 0) memcpy(bytes, list->bytes, list->len);
+	list->bytes = bytes;
+	list->cap = cap;
+}
+
+
+/**
+ *
+ * Adds numTimes appearances of the word in file fileId. The usual case is a
+ * fileId bigger than all the others, which is appended at the end. A file
+ * that arrives out of order is appended after the sorted part with its
+ * own fileId, in constant time as well: the list is sorted once, with
+ * sortPostingList, when the build has finished.
+ *
+ */
+void addPosting(PostingList *list, Arena *arena, int fileId, int numTimes){
+	reservePostings(list, arena, POSTING_MAXBYTES);
+
+	if (list->sorted == list->len && fileId > list->lastFile) {
+		list->len += putVarint(list->bytes + list->len, fileId - list->lastFile - 1);
+		list->len += putVarint(list->bytes + list->len, numTimes);
+		list->sorted = list->len;
+		list->lastFile = fileId;
+		return;
+	}
+
+	// fitxer fora d'ordre: va a la part desordenada
+	list->len += putVarint(list->bytes + list->len, fileId);
+	list->len += putVarint(list->bytes + list->len, numTimes);
+	if (fileId > list->lastFile) list->lastFile = fileId;
+}
+
+
+static int comparePostings(const void *a, const void *b){
+	const int *pa = (const int *) a, *pb = (const int *) b;
+
+	return (pa[0] > pb[0]) - (pa[0] < pb[0]);
+}
+
+
+/**
+ *
+ * Puts the files of the part that is not sorted in their place, adding
+ * the counters of a file that is in the list more than once. The pairs
+ * are decoded, sorted and encoded again over the same bytes: the gaps are
+ * never bigger than the fileIds or than the gaps they replace, so the
+ * sorted list is never longer.
+ *
+ */
+void sortPostingList(PostingList *list){
+	PostingIterator it;
+	int *pairs;
+	int i, m, n = 0, prev = -1;
+
+	if (list->sorted == list->len) return;
+
+	pairs = malloc(sizeof(int) * list->len);	//cada parella ocupa 2 bytes com a minim
+	if (pairs == NULL) {
+		printf("insufficient memory (sortPostingList)\n");
+		exit(1);
+	}
+
+	initPostingIterator(&it, list);
+	while (nextPosting(&it)) {
+		pairs[n++] = it.fileId;
+		pairs[n++] = it.numTimes;
+	}
+	qsort(pairs, n / 2, 2 * sizeof(int), comparePostings);
+
+	m = 0;
+	for (i = 0; i < n; i += 2) {
+		if (m > 0 && pairs[m - 2] == pairs[i]) {	//fitxer repetit: sumem els comptadors
+			pairs[m - 1] += pairs[i + 1];
+			continue;
+		}
+		pairs[m++] = pairs[i];
+		pairs[m++] = pairs[i + 1];
+	}
+
+	list->len = 0;
+	for (i = 0; i < m; i += 2) {
+		list->len += putVarint(list->bytes + list->len, pairs[i] - prev - 1);
+		list->len += putVarint(list->bytes + list->len, pairs[i + 1]);
+		prev = pairs[i];
+	}
+
+	list->sorted = list->len;
+	list->lastFile = prev;
+	free(pairs);
+}
+
+
+/**
+ *
+ * Makes dst a copy of src, with its bytes taken from arena.
+ *
+ */
+void copyPostingList(PostingList *dst, Arena *arena, const PostingList *src){
+	initPostingList(dst);
+	if (src->len == 0) return;
+
+	dst->bytes = allocArena(arena, src->len);
+	memcpy(dst->bytes, src->bytes, src->len);
+	dst->len = src->len;
+	dst->cap = src->len;
+	dst->sorted = src->sorted;
+	dst->lastFile = src->lastFile;
+}
+
+
+/**
+ *
+ * Returns the number of times the word appears in file fileId, 0 if it
+ * does not appear.
+ *
+ */
+int getPostingCount(PostingList *list, int fileId){
+	PostingIterator it;
+
+	initPostingIterator(&it, list);
+	while (nextPosting(&it)) {
+		if (it.fileId == fileId) return it.numTimes;
+		if (it.fileId > fileId && list->sorted == list->len) break;
+	}
+	return 0;
+}
+
+
+/**
+ *
+ * Places the iterator before the first posting of the list.
+ *
+ */
+void initPostingIterator(PostingIterator *it, const PostingList *list){
+	it->p = list->bytes;
+	it->end = list->bytes + list->len;
+	it->tail = list->bytes + list->sorted;
+	it->fileId = -1;
+	it->numTimes = 0;
+}
+
+
+/**
+ *
+ * Moves to the next posting. Returns 0 when there are no more.
+ *
+ */
+int nextPosting(PostingIterator *it){
+	unsigned int value, count;
+
+	if (it->p >= it->end) return 0;
+
+	it->p += getVarint(it->p, &value);
+	if (it->p > it->tail) it->fileId = value;	//part desordenada: el fileId, no el salt
+	else it->fileId += value + 1;
+	it->p += getVarint(it->p, &count);
+	it->numTimes = count;
+	return 1;
+}
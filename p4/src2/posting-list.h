@@ -0,0 +1,78 @@
+/**
+ *
+ * Posting list header
+ *
+ * Include this file in order to be able to call the
+ * functions available in posting-list.c. We include
+ * here only those information we want to make visible
+ * to other files.
+ *
+ * Igor Dzinka / Vicent Roig, 2014.
+ *
+ */
+#ifndef POSTING_LIST_H
+#define POSTING_LIST_H
+
+#include "arena.h"
+
+/**
+ *
+ * Maximum number of bytes of an encoded posting: two varints of 32 bits.
+ *
+ */
+#define POSTING_MAXBYTES 10
+
+/**
+ *
+ * List of (fileId, numTimes) pairs of a word, sorted by fileId. Only the
+ * files where the word appears are stored. Each pair is encoded as two
+ * varints: the gap with the previous fileId (fileId - previous - 1, the
+ * first one relative to -1) and numTimes. The bytes live in an arena;
+ * when they do not fit, a buffer twice as big is taken from the arena.
+ *
+ * The files that arrive out of order are appended after the first sorted
+ * bytes as (fileId, numTimes), with the fileId itself instead of the gap,
+ * and sortPostingList puts them in their place once the build is done.
+ *
+ */
+typedef struct PostingList_ {
+	unsigned char *bytes;	/* parelles codificades */
+	int len;				/* bytes ocupats */
+	int cap;				/* bytes reservats */
+	int sorted;				/* bytes de la part ordenada, len si no n'hi ha d'altres */
+	int lastFile;			/* fileId mes gran de la llista, -1 si es buida */
+} PostingList;
+
+/**
+ *
+ * Iterator over a posting list. After a call to nextPosting that returns
+ * 1, fileId and numTimes hold the current pair. The pairs of the part
+ * that is not sorted yet come in the order they were added.
+ *
+ */
+typedef struct PostingIterator_ {
+	const unsigned char *p;
+	const unsigned char *end;
+	const unsigned char *tail;	/* inici de la part desordenada */
+	int fileId;
+	int numTimes;
+} PostingIterator;
+
+/**
+ *
+ * Function heders we want to make visible so that they
+ * can be called from any other file.
+ *
+ */
+void initPostingList(PostingList *list);
+void addPosting(PostingList *list, Arena *arena, int fileId, int numTimes);
+void sortPostingList(PostingList *list);
+void copyPostingList(PostingList *dst, Arena *arena, const PostingList *src);
+int getPostingCount(PostingList *list, int fileId);
+void initPostingIterator(PostingIterator *it, const PostingList *list);
+int nextPosting(PostingIterator *it);
+int putVarint(unsigned char *p, unsigned int value);
+int getVarint(const unsigned char *p, unsigned int *value);
+int checkPostingList(const unsigned char *bytes, int len, int sizeDb, int *numFiles, int *lastFile);
+
+#endif
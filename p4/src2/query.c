@@ -0,0 +1,152 @@
+/**
+ *
+ * Query implementation.
+ *
+ * Lookup of batches of words in the index. The batch is sorted by shard
+ * and then alphabetically, so that the words of a shard are looked for
+ * together and each tree is walked once for all of them.
+ *
+ * Igor Dzinka / Vicent Roig, 2014.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+/**
+ * We include the query.h header. Note the double
+ * quotes.
+ */
+#include "query.h"
+
+
+static int compareQueries(const void *a, const void *b){
+	const Query *q1 = *(const Query **) a, *q2 = *(const Query **) b;
+
+	if (SHARD(q1->hash) != SHARD(q2->hash)) return SHARD(q1->hash) - SHARD(q2->hash);
+	return strcmp(q1->word, q2->word);
+}
+
+
+/**
+ *
+ * Looks for all the words of the batch. The order of queries is not
+ * changed: the words are sorted through an array of pointers. A frozen
+ * index does not need the sort: its lookup arrays are already read with
+ * few cache misses, and with bench-query the sort makes batches of 256
+ * words or more up to two times slower than looking for them in order.
+ *
+ */
+void lookupWords(Index *index, Query *queries, int numQueries){
+	Query **order;
+	char **keys;
+	RBData **results;
+	int i, start, s;
+
+	if (index->frozen) {
+		for (i = 0; i < numQueries; i++) {
+			queries[i].hash = getHashValue(queries[i].word, strlen(queries[i].word));
+			queries[i].data = findIndexHash(index, queries[i].word, queries[i].hash);
+		}
+		return;
+	}
+
+	order = malloc(sizeof(Query *) * (numQueries + 1));
+	keys = malloc(sizeof(char *) * (numQueries + 1));
+	results = malloc(sizeof(RBData *) * (numQueries + 1));
+	if (order == NULL || keys == NULL || results == NULL) {
+		printf("insufficient memory (lookupWords)\n");
+		exit(1);
+	}
+
+	for (i = 0; i < numQueries; i++) {
+		queries[i].hash = getHashValue(queries[i].word, strlen(queries[i].word));
+		order[i] = &(queries[i]);
+	}
+	qsort(order, numQueries, sizeof(Query *), compareQueries);
+	for (i = 0; i < numQueries; i++) keys[i] = order[i]->word;
+
+	// un recorregut de cada arbre per a totes les paraules del seu shard
+	for (start = 0; start < numQueries; start = i) {
+		s = SHARD(order[start]->hash);
+		for (i = start; i < numQueries && SHARD(order[i]->hash) == s; i++);
+
+		findNodesSorted(&(index->shards[s]), keys + start, results + start, i - start);
+	}
+	for (i = 0; i < numQueries; i++) order[i]->data = results[i];
+
+	free(order);
+	free(keys);
+	free(results);
+}
+
+
+/**
+ *
+ * Reads the words of a file, separated by blanks, and returns them as a
+ * batch of queries. The words are lowercased like the ones of the index,
+ * and the ones longer than MAX_WORDCHR are cut. Returns NULL if the file
+ * can not be read.
+ *
+ */
+Query *readQueryFile(char *filename, int *numQueries){
+	char word[MAX_WORDCHR + 1];
+	Query *queries = NULL, *tmp;
+	int i, size = 0, len, c;
+	FILE *fp;
+
+	fp = fopen(filename, "r");
+	if (!fp) return NULL;
+
+	*numQueries = 0;
+	len = 0;
+	do {
+		c = fgetc(fp);
+		if (c != EOF && !isspace(c)) {
+			if (len < MAX_WORDCHR) word[len++] = tolower(c);
+			continue;
+		}
+		if (len == 0) continue;
+
+		if (*numQueries == size) {
+			size = size ? 2 * size : 64;
+			tmp = realloc(queries, sizeof(Query) * size);
+			if (tmp == NULL) {
+				printf("insufficient memory (readQueryFile)\n");
+				exit(1);
+			}
+			queries = tmp;
+		}
+
+		word[len] = '\0';
+		queries[*numQueries].word = strdup(word);
+		queries[*numQueries].data = NULL;
+		(*numQueries)++;
+		len = 0;
+	} while (c != EOF);
+
+	fclose(fp);
+
+	if (queries == NULL) queries = malloc(sizeof(Query));	//fitxer sense paraules
+	for (i = 0; i < *numQueries; i++)
+		if (queries[i].word == NULL) {
+			printf("insufficient memory (readQueryFile)\n");
+			exit(1);
+		}
+	return queries;
+}
+
+
+/**
+ *
+ * Frees a batch returned by readQueryFile.
+ *
+ */
+void freeQueries(Query *queries, int numQueries){
+	int i;
+
+	for (i = 0; i < numQueries; i++) free(queries[i].word);
+	free(queries);
+}
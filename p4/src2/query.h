@@ -0,0 +1,40 @@
+/**
+ *
+ * Query header
+ *
+ * Include this file in order to be able to call the
+ * functions available in query.c. We include
+ * here only those information we want to make visible
+ * to other files.
+ *
+ * Igor Dzinka / Vicent Roig, 2014.
+ *
+ */
+#ifndef QUERY_H
+#define QUERY_H
+
+#include "index.h"
+
+/**
+ *
+ * A word to look for in the index. lookupWords fills data with the data of
+ * the word (numFiles and its postings), or NULL if it is not in the index.
+ *
+ */
+typedef struct Query_ {
+	char *word;			/* paraula buscada, en minuscules */
+	uint64_t hash;		/* el calcula lookupWords */
+	RBData *data;		/* resultat */
+} Query;
+
+/**
+ *
+ * Function heders we want to make visible so that they
+ * can be called from any other file.
+ *
+ */
+void lookupWords(Index *index, Query *queries, int numQueries);
+Query *readQueryFile(char *filename, int *numQueries);
+void freeQueries(Query *queries, int numQueries);
+
+#endif
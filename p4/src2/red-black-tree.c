@@ -24,34 +24,33 @@
 #include <string.h>
 #include <stdarg.h>
 #include "red-black-tree.h"
+#include "metrics.h"
 
 /**
  * support functions prototypes
  */
-void saveNodesRecursive(Node *node, int *sizeDb, FILE *fp);
-void saveNodeData(Node *node, int *sizeDb, FILE *fp);
-void getStatsRecursive(Node *node, double *treeStats);
-void getTreeStatsRecursive(Node *node, double *treeStats);
 
 
 
 
 /**
  *
- * Free data element. The user should adapt this function to their needs.  This
- * function is called internally by deleteNode.
+ * Allocate data element. The user should adapt this function to their needs.
+ * The data, the copy of the key and the posting list are taken from the
+ * arena of the tree, so they are released all together by deleteTree.
+ * The posting list starts empty.
  *
  */
-static void freeRBData(RBData *data/*, int *sizeDb*/){
-	//print de la tupla amb les dades sol·licitades abans de alliberar memòria
-/*
-	int i, sum = 0;
-	for(i=0; i<*sizeDb; i++) sum += data->numTimes[i];
-	printf("(%d,%s)\n", sum, data->primary_key);
-*/
-	if (data->primary_key) free(data->primary_key);
-	if (data->numTimes) free(data->numTimes);
-	free(data);
+RBData *allocRBData(RBTree *tree, const char *primary_key, int len, uint64_t hash){
+	RBData *data;
+
+	data = allocArena(&(tree->arena), sizeof(RBData));
+	data->primary_key = copyStringArena(&(tree->arena), primary_key, len);
+	data->hash = hash;
+	data->numFiles = 0;
+	initPostingList(&(data->postings));
+
+	return data;
 }
 
 /**
@@ -97,7 +96,7 @@ void initTree(RBTree *tree){
 	tree->root = NIL;
 	tree->numNodes = 0;			/* nombre de nodes al arbre*/
 	tree->sizeDb = 0;				/* tamany de la base de dades*/
-	
+	initArena(&(tree->arena), RBTREE_SLABSIZE);
 }
 
 
@@ -227,7 +226,8 @@ void insertNode(RBTree *tree, RBData *data) {
 	current = tree->root;
 	parent = 0;
 	while (current != NIL) {
-		if (compEQ(data->primary_key, current->data->primary_key)) {
+		METRICS_ADD(METRIC_COMPARISONS, 1);
+		if (data->hash == current->data->hash && compEQ(data->primary_key, current->data->primary_key)) {
 			printf("insertNode: trying to insert but primary key is already in tree.\n");
 			exit(1);
 			//return current;
@@ -237,10 +237,7 @@ void insertNode(RBTree *tree, RBData *data) {
 	}
 
 	/* setup new node */
-	if ((x = malloc (sizeof(*x))) == 0) {
-		printf ("insufficient memory (insertNode)\n");
-		exit(1);
-	}
+	x = allocArena(&(tree->arena), sizeof(*x));
 
 	/* Note that the data is not copied. Just the pointer
 	 is assigned. This means that the pointer to the 
@@ -268,216 +265,312 @@ void insertNode(RBTree *tree, RBData *data) {
 
 /**
  *
- *  Find node containing the specified primary_key. Returns the node.
- *  Returns NULL if not found.
+ *  Links the nodes of data[lo..hi] below parent, taking the middle one as
+ *  the root of the subtree. The subtrees of each node differ at most in one
+ *  node, so all the levels but the last one are full: the nodes of the last
+ *  level are red and the rest black.
+ *
+ */
+static Node *buildRecursive(Node *nodes, RBData **data, int lo, int hi, Node *parent, int depth, int redDepth){
+	Node *x;
+	int mid;
+
+	if (lo > hi) return NIL;
+
+	mid = lo + (hi - lo) / 2;
+	x = &(nodes[mid]);
+	x->data = data[mid];
+	x->parent = parent;
+	x->color = (depth == redDepth) ? RED : BLACK;
+	x->left = buildRecursive(nodes, data, lo, mid - 1, x, depth + 1, redDepth);
+	x->right = buildRecursive(nodes, data, mid + 1, hi, x, depth + 1, redDepth);
+
+	return x;
+}
+
+/**
+ *
+ *  Builds the tree from numData data sorted by key, in linear time: there
+ *  are no searches and no rotations. The tree has to be empty. Returns 0,
+ *  or -1 (and the tree is not modified) if the keys are not strictly
+ *  increasing, in which case the caller has to use insertNode.
+ *
+ */
+int buildTree(RBTree *tree, RBData **data, int numData){
+	Node *nodes;
+	int i, height = 0;
+
+	for (i = 1; i < numData; i++)
+		if (!compLT(data[i-1]->primary_key, data[i]->primary_key)) return -1;
+
+	if (numData == 0) return 0;
+
+	while (((1L << height) - 1) < numData) height++;	//nivells de l'arbre
+
+	nodes = allocArena(&(tree->arena), sizeof(Node) * numData);
+	tree->root = buildRecursive(nodes, data, 0, numData - 1, NULL, 0, height > 1 ? height - 1 : -1);
+	tree->numNodes = numData;
+
+	return 0;
+}
+
+/**
+ *
+ *  Find node containing the specified primary_key, whose hash value is
+ *  already known. Returns NULL if not found. The keys are only compared
+ *  for equality when the hash values match.
  *
  */
-RBData * findNode(RBTree *tree, TYPE_RBTREE_PRIMARY_KEY primary_key) {
+RBData * findNodeHash(RBTree *tree, TYPE_RBTREE_PRIMARY_KEY primary_key, uint64_t hash) {
 
   Node *current = tree->root;
-  while(current != NIL)
-    if(compEQ(primary_key, current->data->primary_key))
+  while(current != NIL) {
+    METRICS_ADD(METRIC_COMPARISONS, 1);
+    if(hash == current->data->hash && compEQ(primary_key, current->data->primary_key))
       return (current->data);
     else
       current = compLT(primary_key, current->data->primary_key) ?
 	current->left : current->right;
+  }
 
  return NULL;
 }
 
 /**
  *
- *  Function used to delete a tree. Do not call directly. 
+ *  Looks for the sorted keys[lo..hi] below node. The keys smaller than the
+ *  key of the node go to the left subtree and the bigger ones to the right,
+ *  so each node is visited once for the whole batch.
  *
  */
-static void deleteTreeRecursive(Node *x/*, int *sizeDb*/){
-	if (x->right != NIL) deleteTreeRecursive(x->right/*, sizeDb*/);
-	if (x->left != NIL) deleteTreeRecursive(x->left/*, sizeDb*/);
+static void findSortedRecursive(Node *node, char **keys, RBData **results, int lo, int hi){
+	int a, b, mid;
+
+	if (lo > hi) return;
+	if (node == NIL) {
+		for (a = lo; a <= hi; a++) results[a] = NULL;
+		return;
+	}
 
-	freeRBData(x->data/*, sizeDb*/);
-	free(x);
+	// a: primera clau >= node, b: primera clau > node
+	a = lo;
+	b = hi + 1;
+	while (a < b) {
+		mid = a + (b - a) / 2;
+		if (compLT(keys[mid], node->data->primary_key)) a = mid + 1;
+		else b = mid;
+	}
+	for (b = a; b <= hi && compEQ(keys[b], node->data->primary_key); b++) results[b] = node->data;
+
+	findSortedRecursive(node->left, keys, results, lo, a - 1);
+	findSortedRecursive(node->right, keys, results, b, hi);
 }
 
+/**
+ *
+ *  Finds a batch of numKeys keys sorted alphabetically (repetitions are
+ *  allowed). results[i] gets the data of keys[i], or NULL if it is not in
+ *  the tree. The upper levels of the tree are read once for the whole
+ *  batch instead of once per key.
+ *
+ */
+void findNodesSorted(RBTree *tree, char **keys, RBData **results, int numKeys){
+	findSortedRecursive(tree->root, keys, results, 0, numKeys - 1);
+}
 
 /**
  *
  *  Delete a tree. All the nodes and all the data pointed to by
- *  the tree is deleted. 
+ *  the tree is deleted. They all live in the arena of the tree, so
+ *  this only frees its slabs; the nodes are not visited.
  *
  */
 void deleteTree(RBTree *tree){
-	//int *ptr = &(tree->sizeDb);
-	if (tree->root != NIL) deleteTreeRecursive(tree->root/*, ptr*/);
+	deleteArena(&(tree->arena));
+	tree->root = NIL;
+	tree->numNodes = 0;
 }
 
 
 /**
  *
- * Funció que copia el contingut de una hashtable al arbre global
+ *  Returns the node with the smallest key, NULL if the tree is empty.
  *
- */ 
-void copyHashTableToTree(List *hashtable, RBTree *tree, int idFile, int *numFiles){
-	RBData *data;
-	ListItem *current;
-
-	char *paraula;
-	int i, j, len, numItems;
-
-	for(i = 0; i < HASHSIZE; i++) {
-		numItems = hashtable[i].numItems;
-		current = hashtable[i].first;
-
-		for(j = 0; j < numItems; j++) {
-			/* Search if the key is in the tree */
-			data = findNode(tree, current->data->primary_key);
-
-			if (data != NULL) {
-				//printf("\t[RED_BLACK_TREE][paraula ja continguda!!][%s]\n", current->data->primary_key);
-				
-				data->numFiles++;
-				data->numTimes[idFile] = current->data->numTimes;
-			} else {
-				// If the key is not in the tree, allocate memory for the data and insert in the tree.
-				data = malloc(sizeof(RBData));
-				len = strlen(current->data->primary_key);		//mirem tamany de la paraula
+ */
+Node *firstNode(RBTree *tree){
+	Node *x = tree->root;
 
-				paraula = malloc(sizeof(char) * (len + 1));		//reservem espai
-				strcpy(paraula, current->data->primary_key);	//copiem la paraula
+	if (x == NIL) return NULL;
+	while (x->left != NIL) x = x->left;
+	return x;
+}
 
-				data->primary_key = paraula;	//asignem la paraula com primary  key
-				data->numFiles = 1;				//es un nou node per tant numFiles val 1
+/**
+ *
+ *  Returns the node that follows x in key order, NULL after the last
+ *  one. It climbs with the parent pointers, so no stack is needed.
+ *
+ */
+Node *nextNode(Node *x){
+	Node *y;
 
-				data->numTimes = calloc((*numFiles), sizeof(int));//reservem memoria per a array amb cops que surt la paraula a cada fitxer 
-				//for(k = 0; k < numFiles; k++)  data->numTimes[k] = 0;	//omplim array amb zeros
+	if (x->right != NIL) {
+		x = x->right;
+		while (x->left != NIL) x = x->left;
+		return x;
+	}
 
-				data->numTimes[idFile] = current->data->numTimes;	// a la posicio  del fitxer actual li posem un 1
-				
-				insertNode(tree, data);								//inserim el node
-				//printf("\t[RED_BLACK_TREE][nova paraula][%s][numNodes%d]\n", current->data->primary_key, tree->numNodes);
-			}
-			
-			current = current->next;	//avancem el punter dins de la llista
-		}
+	y = x->parent;
+	while (y && x == y->right) {
+		x = y;
+		y = y->parent;
 	}
+	return y;
 }
 
 /**
- * Functions used to save the RBTree into the specified binary file.
- * Based on deleteTree / deleteRecursive functions.
+ *
+ *  Returns the first node with a key not smaller than primary_key (if
+ *  upper is 0) or bigger than primary_key (if upper is 1), NULL if there
+ *  is none. It goes down the tree once, without recursion.
+ *
  */
-
-void saveTree(RBTree *tree, char* filename){
-	if (tree->root != NIL){
-		FILE *fp;
-		fp = fopen(filename, "w");
-		if(!fp) return;
-
-		fwrite(&(tree->sizeDb), sizeof(int), 1, fp );
-		fwrite(&(tree->numNodes), sizeof(int), 1, fp );
-		
-		saveNodesRecursive(tree->root, &(tree->sizeDb), fp);
-		fclose(fp);
+static Node *boundNode(RBTree *tree, TYPE_RBTREE_PRIMARY_KEY primary_key, int upper){
+	Node *x = tree->root, *bound = NULL;
+	int cmp;
+
+	while (x != NIL) {
+		cmp = strcmp(x->data->primary_key, primary_key);
+		if (cmp > 0 || (cmp == 0 && !upper)) {
+			bound = x;	//candidat, en busquem un de mes petit a l'esquerra
+			x = x->left;
+		} else {
+			x = x->right;
+		}
 	}
+	return bound;
 }
 
-void saveNodesRecursive(Node *node, int *sizeDb, FILE *fp){
-	 saveNodeData(node, sizeDb, fp);
-	 
-	 if(node->left != NIL) saveNodesRecursive(node->left, sizeDb,fp);
-	 if(node->right != NIL) saveNodesRecursive(node->right, sizeDb,fp);
+/**
+ *
+ *  First node with key >= primary_key. Together with nextNode it walks a
+ *  range of keys in order.
+ *
+ */
+Node *lowerBoundNode(RBTree *tree, TYPE_RBTREE_PRIMARY_KEY primary_key){
+	return boundNode(tree, primary_key, 0);
 }
 
-void saveNodeData(Node *node, int *sizeDb, FILE *fp){
-	
-	int length = strlen(node->data->primary_key);
-	fwrite(&(length), sizeof(int), 1, fp);
-	fwrite(node->data->primary_key, sizeof(char), length, fp);
-	fwrite(&(node->data->numFiles), sizeof(int), 1, fp);
-	fwrite(node->data->numTimes, sizeof(int), *sizeDb, fp );
+/**
+ * Reads the header of a tree file (see TREEFILE_MAGIC), or of a file of
+ * the first version (without magic). Returns TREEFILE_POSTINGS or TREEFILE_BASELINE,
+ * or -1 if the header is damaged.
+ */
+int readTreeHeader(FILE *fp, int *sizeDb, int *numNodes){
+	char magic[8];
+	int format = TREEFILE_POSTINGS;
+
+	if(fread(magic, sizeof(char), sizeof(magic), fp) != sizeof(magic)) return -1;
+	if(memcmp(magic, TREEFILE_MAGIC, sizeof(magic)) == 0){
+		if(fread(sizeDb, sizeof(int), 1, fp) != 1) return -1;
+		if(fread(numNodes, sizeof(int), 1, fp) != 1) return -1;
+	}
+	else{	//primera versio: els 8 bytes son sizeDb i numNodes
+		memcpy(sizeDb, magic, sizeof(int));
+		memcpy(numNodes, magic + sizeof(int), sizeof(int));
+		format = TREEFILE_BASELINE;
+	}
+	if(*sizeDb < 1 || *numNodes < 1) return -1;
+
+	return format;
 }
 
 
 /**
- * Functions used to load the RBTree from a specified binary file.
+ * Reads the key of a record and its hash value (stored in the tree files,
+ * computed for the files of the first version). key must have
+ * room for MAX_WORDCHR + 1 characters. Returns the length of the key, or
+ * -1 if the file is damaged.
  */
+int readRBKey(FILE *fp, int format, char *key, uint64_t *hash){
+	int length = 0;
 
-RBTree * loadTree(char *filename){
-	RBTree *tree = malloc(sizeof(RBTree));
-	initTree(tree);
-
-	FILE *fp;
-	fp = fopen(filename, "r");
-	if(!fp){
+	if(fread(&(length), sizeof(int), 1, fp) != 1) return -1;
+	if(length < 1 || length > MAX_WORDCHR) return -1;	//fitxer malmes
+	if(fread(key, sizeof(char), length, fp) != (size_t) length) return -1;
+	key[length] = '\0';
 
-		deleteTree(tree);
-		free(tree);
-		return NULL;
-	}
-	
-	int sizeDb, numNodes = NULL;
-	fread( &(sizeDb), sizeof(int), 1, fp );
-	fread( &(numNodes), sizeof(int), 1, fp );
-	if(numNodes == 0){
-		fclose(fp);
-		deleteTree(tree);
-		free(tree);
-		return NULL;
-	}
+	if(format == TREEFILE_BASELINE) *hash = getHashValue(key, length);
+	else if(fread(hash, sizeof(uint64_t), 1, fp) != 1) return -1;
 
-	int i;
-	for(i=0; i< numNodes; i++){
-		RBData *data = malloc(sizeof(RBData));
-		int length = NULL;
-
-		fread(&(length), sizeof(int), 1, fp);
-		data->primary_key = malloc(sizeof(char) * (length+1) );
-		fread(data->primary_key, sizeof(char), length, fp);
-		data->primary_key[length] = '\0';
+	return length;
+}
 
-		fread(&(data->numFiles), sizeof(int), 1, fp);
-		data->numTimes = malloc(sizeof(int) * sizeDb);
-		fread(data->numTimes, sizeof(int), sizeDb, fp);
 
-		insertNode(tree, data);
+/**
+ * Reads the counters of a record of the first version (numFiles and one
+ * counter per file of the database) and builds the posting list of data.
+ */
+static int readRBCounters(FILE *fp, RBTree *tree, RBData *data){
+	int i, numTimes, numFiles = 0;
+
+	if(fread(&(numFiles), sizeof(int), 1, fp) != 1) return -1;
+
+	data->numFiles = 0;
+	initPostingList(&(data->postings));
+	for(i = 0; i < tree->sizeDb; i++){
+		if(fread(&(numTimes), sizeof(int), 1, fp) != 1 || numTimes < 0) return -1;
+		if(numTimes == 0) continue;
+		addPosting(&(data->postings), &(tree->arena), i, numTimes);
+		data->numFiles++;
 	}
+	if(data->numFiles == 0 || data->numFiles != numFiles) return -1;	//fitxer malmes
 
-	fclose(fp);
-	return tree;
+	return 0;
 }
 
+
 /**
- * funció que calcula les dades per a histograma 
+ * Reads the rest of the record (numFiles and the posting list) into data,
+ * which belongs to tree. The bytes of the list of a tree file are
+ * kept as they are, once checkPostingList has checked them. Returns 0, or
+ * -1 if the file is damaged.
  */
-double * getTreeStats(RBTree* tree){
-	int i;
-	double *treeStats = calloc(MAX_WORDCHR,sizeof(double));
-	getTreeStatsRecursive(tree->root, treeStats);
+int readRBPostings(FILE *fp, int format, RBTree *tree, RBData *data){
+	int numBytes = 0, numFiles;
 
-	//fem la normalització  de les dades;
-	for(i = 0; i < MAX_WORDCHR; i++) treeStats[i] /= tree->numNodes;
+	if(format == TREEFILE_BASELINE) return readRBCounters(fp, tree, data);
 
-	return treeStats;
-}
+	if(fread(&(data->numFiles), sizeof(int), 1, fp) != 1) return -1;
+	if(fread(&(numBytes), sizeof(int), 1, fp) != 1) return -1;
+	if(data->numFiles < 1 || numBytes < 2 || numBytes > data->numFiles * POSTING_MAXBYTES) return -1;
 
-void getTreeStatsRecursive(Node *node, double *treeStats){
-	if (node != NIL){
-		int len = strlen(node->data->primary_key);
-		treeStats[len-1] += 1.0;
-	
-		getTreeStatsRecursive(node->left, treeStats);
-		getTreeStatsRecursive(node->right, treeStats);
-	}
+	data->postings.bytes = allocArena(&(tree->arena), numBytes);
+	data->postings.len = data->postings.cap = data->postings.sorted = numBytes;
+	if(fread(data->postings.bytes, sizeof(char), numBytes, fp) != (size_t) numBytes) return -1;
+
+	if(checkPostingList(data->postings.bytes, numBytes, tree->sizeDb, &numFiles, &(data->postings.lastFile)) != 0) return -1;
+	if(numFiles != data->numFiles) return -1;	//fitxer malmes
+
+	return 0;
 }
 
-void drawTreeStats(RBTree *tree){
-	double *treeStats = getTreeStats(tree); //obtenim les dades per a histograma
+
+/**
+ * Escriu l'histograma de longituds de paraula (MAX_WORDCHR valors ja
+ * normalitzats) i el dibuixa amb gnuplot.
+ */
+void plotTreeStats(double *treeStats){
 	FILE *fp,*fpout;
 	
 	fp = fopen("../proves/treeStats.dat", "w");
+	if (!fp){
+		printf("ERROR: no puc crear ../proves/treeStats.dat\n");
+		return;
+	}
 	int i;
 	for(i = 1; i <= MAX_WORDCHR; i++) fprintf(fp, "%d %f\n", i, treeStats[i-1]);
 	fclose(fp);
-	free(treeStats);
 
 	fpout = popen("gnuplot -persist", "w");
 	if (!fpout){
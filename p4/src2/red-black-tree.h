@@ -5,11 +5,27 @@
  * See red-black-tree.h for details.
  * 
  */
+#ifndef RED_BLACK_TREE_H
+#define RED_BLACK_TREE_H
+
 #include "hash-table.h"
+#include "arena.h"
+#include "posting-list.h"
 
-#define MAX_WORDCHR 75		//long. maxima per buffer de paraula
+#define RBTREE_SLABSIZE (1024 * 1024)	//tamany dels blocs de memoria de l'arbre
 #define TYPE_RBTREE_PRIMARY_KEY char *  // treballarem amb cadenes de caracters 
 
+/**
+ * The tree files written by the earlier versions (with saveTree, now
+ * replaced by saveIndex) begin with TREEFILE_MAGIC, followed by sizeDb and
+ * numNodes. Only the functions that read them are left, for loadIndex. The files of the first version of the practica have no magic:
+ * they begin with sizeDb and numNodes, and each record has the key,
+ * numFiles and the sizeDb counters of the word.
+ */
+#define TREEFILE_MAGIC "SO2TREE2"
+#define TREEFILE_BASELINE 0	//fitxer sense magic: comptadors per fitxer
+#define TREEFILE_POSTINGS 1	//fitxer d'arbre: hash i llista de postings
+
 /**
  *
  * This structure holds the information to be stored at each node. Change this
@@ -25,11 +41,12 @@ typedef struct RBData_ {
 	// The type may be any you want (float, char *, etc)
 
 	TYPE_RBTREE_PRIMARY_KEY primary_key;     //la paraula serà la key del node
+	uint64_t hash;		//getHashValue de la paraula, calculat pel tokenitzador
 
 	// This is the additional information that will be stored
 	// within the structure.
 	int numFiles; 	//quantitat de fitxers en el que ha aparegut una paraula
-	int *numTimes;	//llista amb quantitat de cops que apareix una paraula dins de cada fitxer fitxer
+	PostingList postings;	//cops que apareix la paraula dins de cada fitxer on apareix
 } RBData;
 
 /**
@@ -55,6 +72,8 @@ typedef struct Node_ {
  *
  * The tree structure. It just contains the root node, from
  * which we may go through all the nodes of the binary tree.
+ * The nodes, their data and the keys are allocated from the
+ * arena of the tree.
  *
  */
 
@@ -63,6 +82,7 @@ typedef struct RBTree_ {
   
   int numNodes;			/* nombre de nodes al arbre*/
   int sizeDb;			/* tamany de la base de dades*/
+  Arena arena;			/* memoria dels nodes, les dades i les paraules */
  
 } RBTree;
 
@@ -72,11 +92,18 @@ typedef struct RBTree_ {
  * red-black-tree.c have been included here.
  */
 void initTree(RBTree *tree);
+RBData *allocRBData(RBTree *tree, const char *primary_key, int len, uint64_t hash);
 void insertNode(RBTree *tree, RBData *data);
-RBData *findNode(RBTree *tree, TYPE_RBTREE_PRIMARY_KEY primary_key); 
+int buildTree(RBTree *tree, RBData **data, int numData);
+RBData *findNodeHash(RBTree *tree, TYPE_RBTREE_PRIMARY_KEY primary_key, uint64_t hash);
+void findNodesSorted(RBTree *tree, char **keys, RBData **results, int numKeys);
 void deleteTree(RBTree *tree);
-void copyHashTableToTree(List *hashtable, RBTree *tree, int idFile, int* numFiles);
-void saveTree(RBTree *tree, char *filename);
-RBTree * loadTree(char *filename);
-double *getTreeStats(RBTree* tree);
-void drawTreeStats(RBTree *tree);
\ No newline at end of file
+Node *firstNode(RBTree *tree);
+Node *nextNode(Node *x);
+Node *lowerBoundNode(RBTree *tree, TYPE_RBTREE_PRIMARY_KEY primary_key);
+int readTreeHeader(FILE *fp, int *sizeDb, int *numNodes);
+int readRBKey(FILE *fp, int format, char *key, uint64_t *hash);
+int readRBPostings(FILE *fp, int format, RBTree *tree, RBData *data);
+void plotTreeStats(double *treeStats);
+
+#endif
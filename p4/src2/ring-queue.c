@@ -0,0 +1,210 @@
+/**
+ *
+ * Ring queue implementation.
+ *
+ * Lock-free bounded queue used to hand the tables of the processed files
+ * from the producers to the consumers. The threads only enter the kernel
+ * to sleep when the queue is full or empty, and to wake a sleeping one.
+ *
+ * Igor Dzinka / Vicent Roig, 2014.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+/**
+ * We include the ring-queue.h header. Note the double
+ * quotes.
+ */
+#include "ring-queue.h"
+
+
+static void futexWait(unsigned int *addr, unsigned int value){
+	syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, value, NULL, NULL, 0);	//torna de seguida si *addr != value
+}
+
+
+static void futexWake(unsigned int *addr, int numThreads){
+	syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, numThreads, NULL, NULL, 0);
+}
+
+
+/**
+ *
+ * Initialize an empty queue for at least capacity items.
+ *
+ */
+void initRingQueue(RingQueue *queue, int capacity){
+	unsigned int i, size = 2;
+
+	while (size < (unsigned int) capacity) size <<= 1;
+
+	queue->slots = malloc(sizeof(RingSlot) * size);
+	if (queue->slots == NULL) {
+		printf("insufficient memory (initRingQueue)\n");
+		exit(1);
+	}
+	for (i = 0; i < size; i++) queue->slots[i].seq = i;
+
+	queue->mask = size - 1;
+	queue->closed = 0;
+	queue->tail = 0;
+	queue->pushes = 0;
+	queue->emptyWaiters = 0;
+	queue->head = 0;
+	queue->pops = 0;
+	queue->fullWaiters = 0;
+}
+
+
+/**
+ *
+ * Frees the slots. The items left in the queue are not freed.
+ *
+ */
+void deleteRingQueue(RingQueue *queue){
+	free(queue->slots);
+	queue->slots = NULL;
+}
+
+
+/**
+ *
+ * Adds item if there is room. Returns 0 on success and -1 if the queue is
+ * full.
+ *
+ */
+int tryPushRingQueue(RingQueue *queue, void *item){
+	unsigned int pos, seq;
+	RingSlot *slot;
+	int diff;
+
+	pos = __atomic_load_n(&(queue->tail), __ATOMIC_RELAXED);
+	while (1) {
+		slot = &(queue->slots[pos & queue->mask]);
+		seq = __atomic_load_n(&(slot->seq), __ATOMIC_ACQUIRE);
+		diff = (int) (seq - pos);
+
+		if (diff == 0) {	//lliure: provem d'agafar la posicio
+			if (__atomic_compare_exchange_n(&(queue->tail), &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) break;
+		} else if (diff < 0) {	//encara no s'ha llegit el de la volta anterior
+			return -1;
+		} else {			//un altre productor ens l'ha pres
+			pos = __atomic_load_n(&(queue->tail), __ATOMIC_RELAXED);
+		}
+	}
+
+	slot->item = item;
+	__atomic_store_n(&(slot->seq), pos + 1, __ATOMIC_RELEASE);
+
+	__atomic_add_fetch(&(queue->pushes), 1, __ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&(queue->emptyWaiters), __ATOMIC_SEQ_CST) > 0) futexWake(&(queue->pushes), 1);
+	return 0;
+}
+
+
+/**
+ *
+ * Takes the oldest item. Returns NULL if the queue is empty.
+ *
+ */
+void *tryPopRingQueue(RingQueue *queue){
+	unsigned int pos, seq;
+	RingSlot *slot;
+	void *item;
+	int diff;
+
+	pos = __atomic_load_n(&(queue->head), __ATOMIC_RELAXED);
+	while (1) {
+		slot = &(queue->slots[pos & queue->mask]);
+		seq = __atomic_load_n(&(slot->seq), __ATOMIC_ACQUIRE);
+		diff = (int) (seq - (pos + 1));
+
+		if (diff == 0) {
+			if (__atomic_compare_exchange_n(&(queue->head), &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) break;
+		} else if (diff < 0) {	//encara no s'ha escrit
+			return NULL;
+		} else {
+			pos = __atomic_load_n(&(queue->head), __ATOMIC_RELAXED);
+		}
+	}
+
+	item = slot->item;
+	__atomic_store_n(&(slot->seq), pos + queue->mask + 1, __ATOMIC_RELEASE);	//lliure per a la seguent volta
+
+	__atomic_add_fetch(&(queue->pops), 1, __ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&(queue->fullWaiters), __ATOMIC_SEQ_CST) > 0) futexWake(&(queue->pops), 1);
+	return item;
+}
+
+
+/**
+ *
+ * Adds item, waiting while the queue is full. The value of pops is read
+ * before trying: if a consumer frees a slot after that, the futex does
+ * not sleep. Returns the number of times the thread slept, so that the
+ * caller can tell a wait for a full queue apart.
+ *
+ */
+int pushRingQueue(RingQueue *queue, void *item){
+	unsigned int seen;
+	int spins = 0, sleeps = 0;
+
+	while (1) {
+		seen = __atomic_load_n(&(queue->pops), __ATOMIC_SEQ_CST);
+		if (tryPushRingQueue(queue, item) == 0) return sleeps;
+		if (spins++ < RING_SPINS) continue;
+
+		__atomic_add_fetch(&(queue->fullWaiters), 1, __ATOMIC_SEQ_CST);
+		futexWait(&(queue->pops), seen);
+		__atomic_sub_fetch(&(queue->fullWaiters), 1, __ATOMIC_SEQ_CST);
+		sleeps++;
+	}
+}
+
+
+/**
+ *
+ * Takes the oldest item, waiting while the queue is empty. Returns NULL
+ * once the queue is closed and empty. If sleeps is not NULL, it gets the
+ * number of times the thread slept.
+ *
+ */
+void *popRingQueue(RingQueue *queue, int *sleeps){
+	unsigned int seen;
+	void *item;
+	int closed, spins = 0, n = 0;
+
+	while (1) {
+		seen = __atomic_load_n(&(queue->pushes), __ATOMIC_SEQ_CST);
+		closed = __atomic_load_n(&(queue->closed), __ATOMIC_SEQ_CST);
+		item = tryPopRingQueue(queue);
+		if (item != NULL || closed) break;	//tancada abans de trobar-la buida: no n'arribaran mes
+		if (spins++ < RING_SPINS) continue;
+
+		__atomic_add_fetch(&(queue->emptyWaiters), 1, __ATOMIC_SEQ_CST);
+		futexWait(&(queue->pushes), seen);
+		__atomic_sub_fetch(&(queue->emptyWaiters), 1, __ATOMIC_SEQ_CST);
+		n++;
+	}
+	if (sleeps != NULL) *sleeps = n;
+	return item;
+}
+
+
+/**
+ *
+ * Tells the consumers that no more items will be pushed. They take the
+ * items that are left and then popRingQueue returns NULL.
+ *
+ */
+void closeRingQueue(RingQueue *queue){
+	__atomic_store_n(&(queue->closed), 1, __ATOMIC_SEQ_CST);
+	__atomic_add_fetch(&(queue->pushes), 1, __ATOMIC_SEQ_CST);
+	futexWake(&(queue->pushes), INT_MAX);
+}
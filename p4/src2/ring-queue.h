@@ -0,0 +1,69 @@
+/**
+ *
+ * Ring queue header
+ *
+ * Include this file in order to be able to call the
+ * functions available in ring-queue.c. We include
+ * here only those information we want to make visible
+ * to other files.
+ *
+ * Igor Dzinka / Vicent Roig, 2014.
+ *
+ */
+#ifndef RING_QUEUE_H
+#define RING_QUEUE_H
+
+/**
+ *
+ * Number of failed attempts before a thread sleeps on a full or empty
+ * queue.
+ *
+ */
+#define RING_SPINS 100
+
+#define RING_CACHELINE 64
+
+/**
+ *
+ * Bounded queue of pointers for several producers and several consumers
+ * (MPMC; one consumer is the MPSC case). It has no locks: every slot has a
+ * sequence number that tells whether it is ready to be written (seq equal
+ * to the position) or read (position + 1), and the positions are taken
+ * with compare and swap (Dmitry Vyukov's bounded queue). A thread that
+ * finds the queue full or empty sleeps on a futex, pushes or pops, which
+ * changes every time an item goes in or out; the wake up system call is
+ * only done if some thread is sleeping. The items can not be NULL.
+ *
+ */
+typedef struct RingSlot_ {
+	unsigned int seq;
+	void *item;
+} RingSlot;
+
+typedef struct RingQueue_ {
+	RingSlot *slots;
+	unsigned int mask;			/* capacitat - 1, la capacitat es potencia de 2 */
+	int closed;
+	unsigned int tail __attribute__((aligned(RING_CACHELINE)));		/* seguent posicio a escriure */
+	unsigned int pushes;		/* futex dels consumidors */
+	int emptyWaiters;			/* consumidors adormits */
+	unsigned int head __attribute__((aligned(RING_CACHELINE)));		/* seguent posicio a llegir */
+	unsigned int pops;			/* futex dels productors */
+	int fullWaiters;			/* productors adormits */
+} RingQueue;
+
+/**
+ *
+ * Function heders we want to make visible so that they
+ * can be called from any other file.
+ *
+ */
+void initRingQueue(RingQueue *queue, int capacity);
+void deleteRingQueue(RingQueue *queue);
+int tryPushRingQueue(RingQueue *queue, void *item);
+void *tryPopRingQueue(RingQueue *queue);
+int pushRingQueue(RingQueue *queue, void *item);
+void *popRingQueue(RingQueue *queue, int *sleeps);
+void closeRingQueue(RingQueue *queue);
+
+#endif
@@ -0,0 +1,287 @@
+/**
+ *
+ * Scheduler implementation.
+ *
+ * Dynamic assignment of the files of the database to the threads that
+ * process them, with work stealing and the biggest files first.
+ *
+ * Igor Dzinka / Vicent Roig, 2014.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/**
+ * We include the scheduler.h header. Note the double
+ * quotes.
+ */
+#include "scheduler.h"
+#include "lock-profile.h"
+
+static LockSite siteOwnDeque = LOCK_SITE("cua propia del planificador");
+static LockSite siteStealDeque = LOCK_SITE("robatori del planificador");
+
+
+/**
+ *
+ * Returns the number of processors online, at least 1 (see coreinfo.c).
+ *
+ */
+int getNumProcessors(void){
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+	return n > 0 ? (int) n : 1;
+}
+
+
+/**
+ * Un fitxer de la llista amb el seu tamany, per ordenar-los sense estat
+ * global.
+ */
+typedef struct FileSize_ {
+	off_t size;
+	int file;			/* posicio dins de la llista de fitxers */
+} FileSize;
+
+static int compareBySize(const void *a, const void *b){
+	const FileSize *fa = a, *fb = b;
+
+	if (fa->size != fb->size) return fa->size < fb->size ? 1 : -1;	//el mes gran primer
+	return fa->file - fb->file;		//empat: ordre de la llista
+}
+
+
+/**
+ *
+ * Stats all the files and deals them to numWorkers deques in decreasing
+ * size: file k of the sorted list goes to worker k % numWorkers. A file
+ * that can not be stat'ed counts as empty; processing it reports the error.
+ * Returns 0, or -1 if there is not enough memory.
+ *
+ */
+int initScheduler(Scheduler *sched, char **fileList, int numFiles, int numWorkers){
+	struct stat st;
+	FileSize *order;
+	int i, w;
+
+	sched->numWorkers = numWorkers;
+	sched->numTasks = 0;
+	sched->numActive = numWorkers;
+	sched->deques = calloc(numWorkers, sizeof(WorkDeque));
+	order = malloc(sizeof(FileSize) * (numFiles + 1));
+	if (sched->deques == NULL || order == NULL) {
+		free(sched->deques);
+		free(order);
+		return -1;
+	}
+	for (w = 0; w < numWorkers; w++) {
+		sched->deques[w].files = malloc(sizeof(int) * (numFiles / numWorkers + 1));
+		if (sched->deques[w].files == NULL) {
+			while (w-- > 0) free(sched->deques[w].files);
+			free(sched->deques);
+			free(order);
+			return -1;
+		}
+	}
+	pthread_mutex_init(&(sched->idleLock), NULL);
+	pthread_cond_init(&(sched->idle), NULL);
+
+	for (i = 0; i < numFiles; i++) {
+		order[i].size = stat(fileList[i], &st) == 0 ? st.st_size : 0;
+		order[i].file = i;
+	}
+	qsort(order, numFiles, sizeof(FileSize), compareBySize);
+
+	for (w = 0; w < numWorkers; w++) {
+		sched->deques[w].head = 0;
+		sched->deques[w].tail = 0;
+		sched->deques[w].tasks = NULL;
+		pthread_mutex_init(&(sched->deques[w].lock), NULL);
+	}
+	for (i = 0; i < numFiles; i++) {
+		w = i % numWorkers;
+		sched->deques[w].files[sched->deques[w].tail++] = order[i].file;
+	}
+
+	free(order);
+	return 0;
+}
+
+
+/**
+ *
+ * Tells the scheduler that numMissing of its workers will never ask for
+ * files (their threads could not be started), so that the others do not
+ * wait for tasks from them. Their files are stolen by the others.
+ *
+ */
+void retireScheduledWorkers(Scheduler *sched, int numMissing){
+	if (numMissing <= 0) return;
+
+	pthread_mutex_lock(&(sched->idleLock));
+	sched->numActive -= numMissing;
+	if (sched->numActive <= 0) pthread_cond_broadcast(&(sched->idle));
+	pthread_mutex_unlock(&(sched->idleLock));
+}
+
+
+/**
+ *
+ * Takes a pending task: the last one given by worker, or else one of the
+ * next worker that has tasks (or only of worker with own). NULL if none.
+ *
+ */
+static SchedTask *takeTask(Scheduler *sched, int worker, int own){
+	WorkDeque *deque;
+	SchedTask *task = NULL;
+	int k;
+	uint64_t since;
+
+	if (__atomic_load_n(&(sched->numTasks), __ATOMIC_ACQUIRE) == 0) return NULL;
+
+	for (k = 0; task == NULL && k < (own ? 1 : sched->numWorkers); k++) {
+		deque = &(sched->deques[(worker + k) % sched->numWorkers]);
+		since = PROFILE_LOCK(&(deque->lock), k == 0 ? &siteOwnDeque : &siteStealDeque, 0);
+		if ((task = deque->tasks) != NULL) deque->tasks = task->next;
+		PROFILE_UNLOCK(&(deque->lock), k == 0 ? &siteOwnDeque : &siteStealDeque, since);
+	}
+
+	if (task != NULL) __atomic_sub_fetch(&(sched->numTasks), 1, __ATOMIC_RELEASE);
+	return task;
+}
+
+
+static void runTask(SchedTask *task){
+	TaskGroup *group = task->group;
+
+	task->run(task->arg);
+
+	pthread_mutex_lock(&(group->lock));
+	if (--group->pending == 0) pthread_cond_broadcast(&(group->done));
+	pthread_mutex_unlock(&(group->lock));
+}
+
+
+/**
+ *
+ * Returns the position in the file list of the next file for worker, or -1
+ * when all the files have been given. The pending tasks are done first.
+ * Then the worker takes the biggest file of its own deque; if it is
+ * empty, it steals the smallest one of the next deque that has files. If
+ * there are no files left it waits for the tasks of the other workers,
+ * and returns -1 once none of them can give more.
+ *
+ */
+int nextScheduledFile(Scheduler *sched, int worker){
+	WorkDeque *deque;
+	SchedTask *task;
+	int k, file, idle = 0;
+	uint64_t since;
+
+	while (1) {
+		if ((task = takeTask(sched, worker, 0)) != NULL) {
+			runTask(task);
+			continue;
+		}
+
+		file = -1;
+		deque = &(sched->deques[worker]);
+		since = PROFILE_LOCK(&(deque->lock), &siteOwnDeque, 0);
+		if (deque->head < deque->tail) file = deque->files[deque->head++];
+		PROFILE_UNLOCK(&(deque->lock), &siteOwnDeque, since);
+
+		for (k = 1; file < 0 && k < sched->numWorkers; k++) {
+			deque = &(sched->deques[(worker + k) % sched->numWorkers]);
+			since = PROFILE_LOCK(&(deque->lock), &siteStealDeque, 0);
+			if (deque->head < deque->tail) file = deque->files[--deque->tail];
+			PROFILE_UNLOCK(&(deque->lock), &siteStealDeque, since);
+		}
+		if (file >= 0) return file;
+
+		//sense fitxers: s'ajuda amb les tasques dels altres mentre n'hi pugui haver
+		pthread_mutex_lock(&(sched->idleLock));
+		if (!idle) {
+			idle = 1;
+			if (--sched->numActive == 0) pthread_cond_broadcast(&(sched->idle));
+		}
+		while ((k = __atomic_load_n(&(sched->numTasks), __ATOMIC_ACQUIRE)) == 0 && sched->numActive > 0)
+			pthread_cond_wait(&(sched->idle), &(sched->idleLock));
+		pthread_mutex_unlock(&(sched->idleLock));
+
+		if (k == 0) return -1;
+	}
+}
+
+
+void initTaskGroup(TaskGroup *group){
+	group->pending = 0;
+	pthread_mutex_init(&(group->lock), NULL);
+	pthread_cond_init(&(group->done), NULL);
+}
+
+
+void deleteTaskGroup(TaskGroup *group){
+	pthread_mutex_destroy(&(group->lock));
+	pthread_cond_destroy(&(group->done));
+}
+
+
+/**
+ *
+ * Gives a task of group to the deque of worker, where the idle workers
+ * can take it. Only worker gives tasks to its deque, and it waits for
+ * them with waitScheduledTasks before asking for the next file.
+ *
+ */
+void pushScheduledTask(Scheduler *sched, int worker, TaskGroup *group, SchedTask *task){
+	WorkDeque *deque = &(sched->deques[worker]);
+	uint64_t since;
+
+	task->group = group;
+	pthread_mutex_lock(&(group->lock));
+	group->pending++;
+	pthread_mutex_unlock(&(group->lock));
+
+	since = PROFILE_LOCK(&(deque->lock), &siteOwnDeque, 0);
+	task->next = deque->tasks;
+	deque->tasks = task;
+	PROFILE_UNLOCK(&(deque->lock), &siteOwnDeque, since);
+
+	pthread_mutex_lock(&(sched->idleLock));
+	__atomic_add_fetch(&(sched->numTasks), 1, __ATOMIC_RELEASE);
+	pthread_cond_broadcast(&(sched->idle));
+	pthread_mutex_unlock(&(sched->idleLock));
+}
+
+
+/**
+ *
+ * Does the tasks of group that nobody has taken yet, and waits for the
+ * ones that other workers are doing.
+ *
+ */
+void waitScheduledTasks(Scheduler *sched, int worker, TaskGroup *group){
+	SchedTask *task;
+
+	while ((task = takeTask(sched, worker, 1)) != NULL) runTask(task);
+
+	pthread_mutex_lock(&(group->lock));
+	while (group->pending > 0) pthread_cond_wait(&(group->done), &(group->lock));
+	pthread_mutex_unlock(&(group->lock));
+}
+
+
+void deleteScheduler(Scheduler *sched){
+	int w;
+
+	for (w = 0; w < sched->numWorkers; w++) {
+		free(sched->deques[w].files);
+		pthread_mutex_destroy(&(sched->deques[w].lock));
+	}
+	free(sched->deques);
+	pthread_mutex_destroy(&(sched->idleLock));
+	pthread_cond_destroy(&(sched->idle));
+}
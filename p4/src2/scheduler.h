@@ -0,0 +1,89 @@
+/**
+ *
+ * Scheduler header
+ *
+ * Include this file in order to be able to call the
+ * functions available in scheduler.c. We include
+ * here only those information we want to make visible
+ * to other files.
+ *
+ * Igor Dzinka / Vicent Roig, 2014.
+ *
+ */
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <pthread.h>
+
+/**
+ *
+ * Piece of work that a worker gives to the scheduler so that the idle
+ * workers can do it, for instance a chunk of a big file. The tasks of a
+ * group are waited for together with waitScheduledTasks.
+ *
+ */
+typedef struct TaskGroup_ {
+	int pending;			/* tasques no acabades */
+	pthread_mutex_t lock;
+	pthread_cond_t done;
+} TaskGroup;
+
+typedef struct SchedTask_ {
+	void (*run)(void *arg);
+	void *arg;
+	TaskGroup *group;
+	struct SchedTask_ *next;
+} SchedTask;
+
+/**
+ *
+ * Files of one worker, in decreasing size. The worker takes them from the
+ * head; the other workers steal from the tail when their own are over.
+ * The tasks given by the worker are kept apart, the last one first.
+ *
+ */
+typedef struct WorkDeque_ {
+	int *files;				/* posicions dins de la llista de fitxers */
+	int head;				/* seguent a agafar pel propietari */
+	int tail;				/* un mes enlla de l'ultim */
+	SchedTask *tasks;		/* tasques pendents del propietari */
+	pthread_mutex_t lock;
+} WorkDeque;
+
+/**
+ *
+ * Work-stealing scheduler of the files of the database. The size of every
+ * file is known before starting, and the files are dealt to the workers
+ * from the biggest to the smallest, so the big ones are processed first
+ * and the small ones fill the gaps at the end. The tasks go before the
+ * files: a worker that asks for a file does first the pending tasks of
+ * any worker, and a worker without files waits for tasks until all the
+ * workers are out of files.
+ *
+ */
+typedef struct Scheduler_ {
+	WorkDeque *deques;		/* una per treballador */
+	int numWorkers;
+	int numTasks;			/* tasques a les cues, no agafades */
+	int numActive;			/* treballadors que encara poden donar tasques */
+	pthread_mutex_t idleLock;
+	pthread_cond_t idle;	/* hi ha tasques noves o ja no en vindran */
+} Scheduler;
+
+/**
+ *
+ * Function heders we want to make visible so that they
+ * can be called from any other file.
+ *
+ */
+int getNumProcessors(void);
+int initScheduler(Scheduler *sched, char **fileList, int numFiles, int numWorkers);
+void retireScheduledWorkers(Scheduler *sched, int numMissing);
+int nextScheduledFile(Scheduler *sched, int worker);
+void initTaskGroup(TaskGroup *group);
+void deleteTaskGroup(TaskGroup *group);
+void pushScheduledTask(Scheduler *sched, int worker, TaskGroup *group, SchedTask *task);
+void waitScheduledTasks(Scheduler *sched, int worker, TaskGroup *group);
+void deleteScheduler(Scheduler *sched);
+
+#endif
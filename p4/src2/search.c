@@ -0,0 +1,440 @@
+/**
+ *
+ * Search implementation.
+ *
+ * Boolean and ranked search over the index. The posting lists of the
+ * words of the query are decoded into sorted arrays of fileIds, combined
+ * with galloping search, and the files are ranked with BM25 or TF-IDF.
+ *
+ * Query syntax: words separated by blanks. Consecutive words are joined
+ * with AND, OR separates groups of words and NOT excludes the files of the
+ * word that follows it (NOT binds tighter than AND, and AND tighter than
+ * OR). The operators have to be written in capitals.
+ *
+ * Igor Dzinka / Vicent Roig, 2014.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+/**
+ * We include the search.h header. Note the double
+ * quotes.
+ */
+#include "search.h"
+#include "query.h"
+
+typedef struct Term_ {
+	int group;			/* grup d'AND, els grups s'uneixen amb OR */
+	int negated;		/* 1 si va despres de NOT */
+	RBData *data;		/* NULL si la paraula no es a l'index */
+	int *files;			/* postings descodificats */
+	int *counts;
+	int numFiles;
+} Term;
+
+typedef struct ParsedQuery_ {
+	Term terms[SEARCH_MAXTERMS];
+	int numTerms;
+	int numGroups;
+	int hasOperators;	/* 0 si es text lliure */
+} ParsedQuery;
+
+
+/**
+ *
+ * Initialize the search engine of an index. It goes once through all the
+ * postings to count the words of each file.
+ *
+ */
+void initSearchEngine(SearchEngine *engine, Index *index, RankFunction rank){
+	PostingIterator it;
+	IndexIterator words;
+	double total = 0;
+	RBData *data;
+
+	engine->index = index;
+	engine->rank = rank;
+	engine->numFiles = index->sizeDb;
+	engine->fileLength = calloc(index->sizeDb + 1, sizeof(double));
+	if (engine->fileLength == NULL) {
+		printf("insufficient memory (initSearchEngine)\n");
+		exit(1);
+	}
+
+	initIndexIterator(&words, index);
+	while ((data = nextIndex(&words)) != NULL) {
+		initPostingIterator(&it, &(data->postings));
+		while (nextPosting(&it)) {
+			engine->fileLength[it.fileId] += it.numTimes;
+			total += it.numTimes;
+		}
+	}
+
+	engine->avgLength = engine->numFiles > 0 ? total / engine->numFiles : 0;
+}
+
+
+/**
+ *
+ * Frees the memory of the search engine. The index is not modified.
+ *
+ */
+void deleteSearchEngine(SearchEngine *engine){
+	free(engine->fileLength);
+	engine->fileLength = NULL;
+}
+
+
+/**
+ *
+ * Splits the query in terms, looks for all of them in the index with one
+ * batch and decodes their postings.
+ *
+ */
+static void parseQuery(SearchEngine *engine, char *query, ParsedQuery *pq){
+	Query queries[SEARCH_MAXTERMS];
+	char *copy, *token, *save;
+	Term *term;
+	PostingIterator it;
+	int i, negated = 0, newGroup = 0;
+
+	pq->numTerms = 0;
+	pq->numGroups = 1;
+	pq->hasOperators = 0;
+
+	copy = strdup(query);
+	for (token = strtok_r(copy, " \t\n", &save); token && pq->numTerms < SEARCH_MAXTERMS; token = strtok_r(NULL, " \t\n", &save)) {
+		if (strcmp(token, "AND") == 0) {
+			pq->hasOperators = 1;
+			continue;
+		}
+		if (strcmp(token, "OR") == 0) {
+			pq->hasOperators = 1;
+			newGroup = 1;
+			continue;
+		}
+		if (strcmp(token, "NOT") == 0) {
+			pq->hasOperators = 1;
+			negated = 1;
+			continue;
+		}
+
+		if (newGroup && pq->numTerms > 0) pq->numGroups++;
+		newGroup = 0;
+
+		if (strlen(token) > MAX_WORDCHR) token[MAX_WORDCHR] = '\0';
+		for (i = 0; token[i]; i++) token[i] = tolower((unsigned char) token[i]);
+
+		term = &(pq->terms[pq->numTerms]);
+		term->group = pq->numGroups - 1;
+		term->negated = negated;
+		queries[pq->numTerms].word = token;
+		pq->numTerms++;
+		negated = 0;
+	}
+
+	lookupWords(engine->index, queries, pq->numTerms);
+
+	for (i = 0; i < pq->numTerms; i++) {
+		term = &(pq->terms[i]);
+		term->data = queries[i].data;
+		term->numFiles = 0;
+		term->files = malloc(sizeof(int) * (term->data ? term->data->numFiles : 1));
+		term->counts = malloc(sizeof(int) * (term->data ? term->data->numFiles : 1));
+		if (term->files == NULL || term->counts == NULL) {
+			printf("insufficient memory (parseQuery)\n");
+			exit(1);
+		}
+		if (term->data == NULL) continue;
+
+		initPostingIterator(&it, &(term->data->postings));
+		while (nextPosting(&it)) {
+			term->files[term->numFiles] = it.fileId;
+			term->counts[term->numFiles++] = it.numTimes;
+		}
+	}
+
+	free(copy);
+}
+
+static void freeQuery(ParsedQuery *pq){
+	int i;
+
+	for (i = 0; i < pq->numTerms; i++) {
+		free(pq->terms[i].files);
+		free(pq->terms[i].counts);
+	}
+}
+
+
+/**
+ *
+ * Returns the first position from lo with a[pos] >= x (n if there is
+ * none). The step doubles until x is passed, and then a binary search is
+ * done in the last step, so the cost depends on the distance skipped and
+ * not on the length of a.
+ *
+ */
+static int gallop(const int *a, int lo, int n, int x){
+	int bound = lo, step = 1, mid;
+
+	while (bound < n && a[bound] < x) {
+		lo = bound + 1;
+		bound += step;
+		step *= 2;
+	}
+	if (bound > n) bound = n;
+
+	while (lo < bound) {
+		mid = lo + (bound - lo) / 2;
+		if (a[mid] < x) lo = mid + 1;
+		else bound = mid;
+	}
+	return lo;
+}
+
+/**
+ *
+ * Operations on sorted lists of fileIds. out can not be a or b. They
+ * return the length of out.
+ *
+ */
+static int intersectFiles(const int *a, int na, const int *b, int nb, int *out){
+	int i, j = 0, n = 0;
+
+	for (i = 0; i < na && j < nb; i++) {
+		j = gallop(b, j, nb, a[i]);
+		if (j < nb && b[j] == a[i]) out[n++] = a[i];
+	}
+	return n;
+}
+
+static int subtractFiles(const int *a, int na, const int *b, int nb, int *out){
+	int i, j = 0, n = 0;
+
+	for (i = 0; i < na; i++) {
+		j = gallop(b, j, nb, a[i]);
+		if (j == nb || b[j] != a[i]) out[n++] = a[i];
+	}
+	return n;
+}
+
+static int uniteFiles(const int *a, int na, const int *b, int nb, int *out){
+	int i = 0, j = 0, n = 0;
+
+	while (i < na || j < nb) {
+		if (j == nb || (i < na && a[i] < b[j])) out[n++] = a[i++];
+		else if (i == na || b[j] < a[i]) out[n++] = b[j++];
+		else {
+			out[n++] = a[i++];
+			j++;
+		}
+	}
+	return n;
+}
+
+
+/**
+ *
+ * Evaluates the boolean query into files, sorted. In each group the
+ * positive terms are intersected starting with the shortest list, so
+ * that the galloping search skips the most.
+ *
+ */
+static int evalQuery(SearchEngine *engine, ParsedQuery *pq, int *files){
+	int *cur, *tmp, *swap, *order;
+	int g, i, j, k, numOrder, numCur, numFiles = 0;
+	Term *term;
+
+	if (pq->numTerms == 0) return 0;	//consulta buida
+
+	cur = malloc(sizeof(int) * (engine->numFiles + 1));
+	tmp = malloc(sizeof(int) * (engine->numFiles + 1));
+	order = malloc(sizeof(int) * (pq->numTerms + 1));
+	if (cur == NULL || tmp == NULL || order == NULL) {
+		printf("insufficient memory (evalQuery)\n");
+		exit(1);
+	}
+
+	for (g = 0; g < pq->numGroups; g++) {
+		// termes positius del grup, de la llista mes curta a la mes llarga
+		numOrder = 0;
+		for (i = 0; i < pq->numTerms; i++) {
+			if (pq->terms[i].group != g || pq->terms[i].negated) continue;
+			for (j = numOrder; j > 0 && pq->terms[order[j-1]].numFiles > pq->terms[i].numFiles; j--) order[j] = order[j-1];
+			order[j] = i;
+			numOrder++;
+		}
+
+		if (numOrder == 0) {		//nomes NOT: partim de tots els fitxers
+			numCur = engine->numFiles;
+			for (i = 0; i < numCur; i++) cur[i] = i;
+		} else {
+			numCur = pq->terms[order[0]].numFiles;
+			memcpy(cur, pq->terms[order[0]].files, sizeof(int) * numCur);
+		}
+
+		for (k = 1; k < numOrder && numCur > 0; k++) {
+			term = &(pq->terms[order[k]]);
+			numCur = intersectFiles(cur, numCur, term->files, term->numFiles, tmp);
+			swap = cur; cur = tmp; tmp = swap;
+		}
+
+		for (i = 0; i < pq->numTerms && numCur > 0; i++) {
+			term = &(pq->terms[i]);
+			if (term->group != g || !term->negated) continue;
+			numCur = subtractFiles(cur, numCur, term->files, term->numFiles, tmp);
+			swap = cur; cur = tmp; tmp = swap;
+		}
+
+		numFiles = uniteFiles(files, numFiles, cur, numCur, tmp);
+		memcpy(files, tmp, sizeof(int) * numFiles);
+	}
+
+	free(cur);
+	free(tmp);
+	free(order);
+	return numFiles;
+}
+
+
+/**
+ *
+ * Returns in files the fileIds that satisfy the boolean query, sorted.
+ * files must have room for all the files of the index.
+ *
+ */
+int matchQuery(SearchEngine *engine, char *query, int *files){
+	ParsedQuery pq;
+	int numFiles;
+
+	parseQuery(engine, query, &pq);
+	numFiles = evalQuery(engine, &pq, files);
+	freeQuery(&pq);
+
+	return numFiles;
+}
+
+
+/**
+ *
+ * Score of a word that appears count times in file, and in df files of
+ * the index.
+ *
+ */
+static double scoreTerm(SearchEngine *engine, int count, int df, int file){
+	double n = engine->numFiles, tf = count, norm;
+
+	if (engine->rank == RANK_TFIDF) return (1.0 + log(tf)) * log(n / df);
+
+	norm = BM25_K1 * (1.0 - BM25_B + BM25_B * engine->fileLength[file] / engine->avgLength);
+	return log(1.0 + (n - df + 0.5) / (df + 0.5)) * tf * (BM25_K1 + 1.0) / (tf + norm);
+}
+
+/**
+ *
+ * Order of the hits: best score first, and the smaller fileId first when
+ * the scores are equal.
+ *
+ */
+static int betterHit(const SearchHit *a, const SearchHit *b){
+	if (a->score != b->score) return a->score > b->score;
+	return a->fileId < b->fileId;
+}
+
+static int compareHits(const void *a, const void *b){
+	return betterHit(b, a) - betterHit(a, b);
+}
+
+/**
+ *
+ * Heap of the best k hits, with the worst one at the top.
+ *
+ */
+static void siftHit(SearchHit *heap, int n, int i){
+	SearchHit tmp;
+	int child;
+
+	while ((child = 2 * i + 1) < n) {
+		if (child + 1 < n && betterHit(&heap[child], &heap[child + 1])) child++;
+		if (!betterHit(&heap[i], &heap[child])) break;
+
+		tmp = heap[i];
+		heap[i] = heap[child];
+		heap[child] = tmp;
+		i = child;
+	}
+}
+
+
+/**
+ *
+ * Ranks the files for the query and returns the best k in hits, best
+ * first. Free text (without operators) ranks every file with some word of
+ * the query; with operators only the files that satisfy it are ranked.
+ * The words after NOT do not add to the score. Returns the number of hits.
+ *
+ */
+int searchIndex(SearchEngine *engine, char *query, SearchHit *hits, int k){
+	ParsedQuery pq;
+	double *scores;
+	char *allowed;
+	int *files;
+	int i, j, numFiles, numHits = 0;
+	SearchHit hit;
+	Term *term;
+
+	scores = calloc(engine->numFiles + 1, sizeof(double));
+	allowed = calloc(engine->numFiles + 1, sizeof(char));
+	files = malloc(sizeof(int) * (engine->numFiles + 1));
+	if (scores == NULL || allowed == NULL || files == NULL) {
+		printf("insufficient memory (searchIndex)\n");
+		exit(1);
+	}
+
+	parseQuery(engine, query, &pq);
+
+	if (pq.hasOperators) {
+		numFiles = evalQuery(engine, &pq, files);
+		for (i = 0; i < numFiles; i++) allowed[files[i]] = 1;
+	} else {
+		memset(allowed, 1, engine->numFiles);
+	}
+
+	// puntuacio, terme a terme
+	for (i = 0; i < pq.numTerms; i++) {
+		term = &(pq.terms[i]);
+		if (term->negated) continue;
+		for (j = 0; j < term->numFiles; j++)
+			if (allowed[term->files[j]])
+				scores[term->files[j]] += scoreTerm(engine, term->counts[j], term->numFiles, term->files[j]);
+	}
+
+	for (i = 0; i < engine->numFiles && k > 0; i++) {
+		if (!allowed[i] || (scores[i] <= 0 && !pq.hasOperators)) continue;
+
+		hit.fileId = i;
+		hit.score = scores[i];
+		if (numHits < k) {
+			hits[numHits++] = hit;
+			if (numHits == k)
+				for (j = k / 2 - 1; j >= 0; j--) siftHit(hits, numHits, j);
+		} else if (betterHit(&hit, &hits[0])) {
+			hits[0] = hit;
+			siftHit(hits, numHits, 0);
+		}
+	}
+	qsort(hits, numHits, sizeof(SearchHit), compareHits);
+
+	freeQuery(&pq);
+	free(scores);
+	free(allowed);
+	free(files);
+
+	return numHits;
+}
@@ -0,0 +1,64 @@
+/**
+ *
+ * Search header
+ *
+ * Include this file in order to be able to call the
+ * functions available in search.c. We include
+ * here only those information we want to make visible
+ * to other files.
+ *
+ * Igor Dzinka / Vicent Roig, 2014.
+ *
+ */
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include "index.h"
+
+#define SEARCH_MAXTERMS 64		// paraules per consulta
+#define SEARCH_TOPK 10			// fitxers que es mostren per consulta
+
+/**
+ *
+ * Parameters of BM25.
+ *
+ */
+#define BM25_K1 1.2
+#define BM25_B 0.75
+
+typedef enum {
+	RANK_BM25,
+	RANK_TFIDF
+} RankFunction;
+
+/**
+ *
+ * Data needed to rank the files of an index: the number of words of each
+ * file, which is computed once from the postings of the index.
+ *
+ */
+typedef struct SearchEngine_ {
+	Index *index;
+	RankFunction rank;
+	int numFiles;
+	double *fileLength;		/* paraules de cada fitxer */
+	double avgLength;		/* mitjana de fileLength */
+} SearchEngine;
+
+typedef struct SearchHit_ {
+	int fileId;
+	double score;
+} SearchHit;
+
+/**
+ *
+ * Function heders we want to make visible so that they
+ * can be called from any other file.
+ *
+ */
+void initSearchEngine(SearchEngine *engine, Index *index, RankFunction rank);
+void deleteSearchEngine(SearchEngine *engine);
+int matchQuery(SearchEngine *engine, char *query, int *files);
+int searchIndex(SearchEngine *engine, char *query, SearchHit *hits, int k);
+
+#endif
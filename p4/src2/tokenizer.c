@@ -0,0 +1,562 @@
+/**
+ *
+ * Tokenizer implementation.
+ *
+ * Reads a whole file at once (mmap or a single read) and extracts its
+ * words. The text is not copied line by line: findWords walks the
+ * buffer and only the words that are new for the hash table are copied,
+ * into the arena of the table. The hash value of each word is computed
+ * here, once, and travels with the word from then on.
+ *
+ * The characters are classified in blocks of 64 bytes with SSE2 or AVX2
+ * when the cpu has them, and with lookup tables otherwise.
+ *
+ * Igor Dzinka / Vicent Roig, 2014.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <ctype.h>			// per les funcions isalpha, isdigit, ...
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+/**
+ * We include the tokenizer.h header. Note the double
+ * quotes.
+ */
+#include "tokenizer.h"
+
+
+/**
+ *
+ * Reads the whole file into a malloc'd buffer. Used when mmap is disabled
+ * or is not available for the file.
+ *
+ */
+static int readWholeFile(int fd, MappedFile *file){
+	size_t done = 0;
+	ssize_t n;
+
+	file->data = malloc(file->size);
+	if (file->data == NULL) return -1;
+
+	while (done < file->size) {
+		n = read(fd, file->data + done, file->size - done);
+		if (n <= 0) {
+			free(file->data);
+			file->data = NULL;
+			return -1;
+		}
+		done += n;
+	}
+	file->mapped = 0;
+	return 0;
+}
+
+
+/**
+ *
+ * Gives access to the contents of filename. Returns 0 on success and -1
+ * if the file can not be opened or read. An empty file is valid and
+ * returns size 0 and data NULL.
+ *
+ */
+int mapFile(char *filename, MappedFile *file){
+	struct stat st;
+	int fd, rc = 0;
+
+	file->data = NULL;
+	file->size = 0;
+	file->mapped = 0;
+
+	fd = open(filename, O_RDONLY);
+	if (fd < 0) return -1;
+
+	if (fstat(fd, &st) < 0) {
+		close(fd);
+		return -1;
+	}
+
+	file->size = st.st_size;
+	if (file->size > 0) {
+		if (USE_MMAP) {
+			file->data = mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (file->data == MAP_FAILED) file->data = NULL;
+			else {
+				madvise(file->data, file->size, MADV_SEQUENTIAL);	//el llegirem d'inici a fi
+				file->mapped = 1;
+			}
+		}
+		if (file->data == NULL) rc = readWholeFile(fd, file);
+	}
+
+	close(fd);
+	return rc;
+}
+
+
+/**
+ *
+ * Releases the contents obtained with mapFile.
+ *
+ */
+void unmapFile(MappedFile *file){
+	if (file->data) {
+		if (file->mapped) munmap(file->data, file->size);
+		else free(file->data);
+	}
+	file->data = NULL;
+	file->size = 0;
+}
+
+
+/**
+ *
+ * Donat un buffer de size caràcters, cerca paraules seguint els criteris
+ * especificats i les guarda a la hashTable. El final del buffer es tracta
+ * com un separador, de manera que l'ultima paraula no es perd encara que
+ * el fitxer no acabi en salt de linia.
+ *
+ * Aquesta es la versio caracter a caracter amb les funcions de ctype.h. Es
+ * la definicio de referencia de les regles: els nuclis per blocs han de
+ * prendre exactament les mateixes decisions.
+ *
+ */
+static HashTable *findWordsCtype(const char *buffer, size_t size, HashTable *hashTable){
+	char word[MAX_WORDCHR + 1];	/* buffer per construir les paraules */
+	unsigned char c;
+	size_t i;
+	int j = 0, validate = 1;
+
+	for (i = 0; i <= size; i++) {
+		c = (i < size) ? buffer[i] : ' ';
+
+		if( isspace(c) || (ispunct(c) && c!='\'') ) { /* determina el final de paraula */
+			// comprovem que no es tracta de una paraula buida -> tenim 1 o més caràcters al buffer
+			if(j > 0){
+				word[j] = '\0';
+
+				//paraula valida; la guardem a la estructura local
+				if(validate) insertHashTable(hashTable, word, j, getHashValue(word, j));
+
+				validate = 1;
+				j = 0;	//reset buffer
+			}
+			if(c == '\n') validate = 1;	//cada linia comença amb l'estat net, com quan es llegia amb fgets
+
+		} else { // el caracter no es tracta de un final de paraula.
+			if(iscntrl(c) || !isascii(c) || isdigit(c)) validate = 0;
+			else {
+				if(isupper(c)) c = tolower(c);
+
+				// abans d'afegir cada un dels caracters contralem la mida del buffer
+				if(j < MAX_WORDCHR) word[j++] = c;
+				else j = 0;
+			}
+		}
+	}
+
+	return hashTable;
+}
+
+
+/**
+ *
+ * Block tokenizer. A kernel classifies BLOCKSIZE bytes at once and returns
+ * one bit per byte in three masks: separators (isspace, or ispunct except
+ * the apostrophe), invalid characters (control, non ascii or digit) and
+ * new lines. It also writes the block lowercased. Every byte that is not a
+ * separator nor invalid is a letter or an apostrophe.
+ *
+ */
+#define BLOCKSIZE 64
+
+typedef struct BlockMasks_ {
+	uint64_t sep;
+	uint64_t bad;
+	uint64_t nl;
+} BlockMasks;
+
+typedef void (*ClassifyFn)(const unsigned char *in, unsigned char *lower, BlockMasks *masks);
+
+/**
+ *
+ * Estat del tokenitzador entre blocs: la paraula que s'esta construint.
+ *
+ */
+typedef struct WordState_ {
+	char word[MAX_WORDCHR + 1];
+	int j;
+	int validate;
+} WordState;
+
+#define CLASS_SEP 1
+#define CLASS_BAD 2
+#define CLASS_NL  4
+
+static unsigned char classTable[256];
+static unsigned char lowerTable[256];
+static ClassifyFn classifyBlock = NULL;
+static TokenizerKernel currentKernel = TOKENIZER_AUTO;
+static pthread_once_t tokenizerOnce = PTHREAD_ONCE_INIT;
+
+
+/**
+ *
+ * Scalar kernel. Uses the tables built from ctype.h once at start up, so
+ * there is one load per byte instead of several calls.
+ *
+ */
+static void classifyBlockScalar(const unsigned char *in, unsigned char *lower, BlockMasks *masks){
+	uint64_t sep = 0, bad = 0, nl = 0, bit;
+	int i;
+
+	for (i = 0; i < BLOCKSIZE; i++) {
+		bit = (uint64_t) 1 << i;
+		if (classTable[in[i]] & CLASS_SEP) sep |= bit;
+		if (classTable[in[i]] & CLASS_BAD) bad |= bit;
+		if (classTable[in[i]] & CLASS_NL) nl |= bit;
+		lower[i] = lowerTable[in[i]];
+	}
+	masks->sep = sep;
+	masks->bad = bad;
+	masks->nl = nl;
+}
+
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/*
+ * Els rangs de ctype.h al locale "C", comparats amb signe: els bytes no ascii
+ * son negatius i no entren a cap rang, per tant queden com a invalids.
+ */
+#define IN_RANGE128(v, lo, hi) \
+	_mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8((lo) - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8((hi) + 1)))
+
+/**
+ *
+ * SSE2 kernel, 16 bytes per step.
+ *
+ */
+__attribute__((target("sse2")))
+static void classifyBlockSSE2(const unsigned char *in, unsigned char *lower, BlockMasks *masks){
+	__m128i v, upper, letter, apos, space, punct, sep, bad;
+	uint64_t m_sep = 0, m_bad = 0, m_nl = 0;
+	int i;
+
+	for (i = 0; i < BLOCKSIZE; i += 16) {
+		v = _mm_loadu_si128((const __m128i *) (in + i));
+
+		upper = IN_RANGE128(v, 'A', 'Z');
+		letter = _mm_or_si128(upper, IN_RANGE128(v, 'a', 'z'));
+		apos = _mm_cmpeq_epi8(v, _mm_set1_epi8('\''));
+		space = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), IN_RANGE128(v, '\t', '\r'));
+		punct = _mm_or_si128(_mm_or_si128(IN_RANGE128(v, '!', '/'), IN_RANGE128(v, ':', '@')),
+				_mm_or_si128(IN_RANGE128(v, '[', '`'), IN_RANGE128(v, '{', '~')));
+		sep = _mm_or_si128(space, _mm_andnot_si128(apos, punct));
+		bad = _mm_andnot_si128(_mm_or_si128(_mm_or_si128(sep, letter), apos), _mm_set1_epi8(-1));
+
+		// A-Z -> a-z sumant 0x20 nomes on hi ha majuscules
+		_mm_storeu_si128((__m128i *) (lower + i), _mm_add_epi8(v, _mm_and_si128(upper, _mm_set1_epi8(0x20))));
+
+		m_sep |= (uint64_t) (unsigned) _mm_movemask_epi8(sep) << i;
+		m_bad |= (uint64_t) (unsigned) _mm_movemask_epi8(bad) << i;
+		m_nl |= (uint64_t) (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))) << i;
+	}
+	masks->sep = m_sep;
+	masks->bad = m_bad;
+	masks->nl = m_nl;
+}
+
+#define IN_RANGE256(v, lo, hi) \
+	_mm256_andnot_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(hi)), _mm256_cmpgt_epi8(v, _mm256_set1_epi8((lo) - 1)))
+
+/**
+ *
+ * AVX2 kernel, 32 bytes per step.
+ *
+ */
+__attribute__((target("avx2")))
+static void classifyBlockAVX2(const unsigned char *in, unsigned char *lower, BlockMasks *masks){
+	__m256i v, upper, letter, apos, space, punct, sep, bad;
+	uint64_t m_sep = 0, m_bad = 0, m_nl = 0;
+	int i;
+
+	for (i = 0; i < BLOCKSIZE; i += 32) {
+		v = _mm256_loadu_si256((const __m256i *) (in + i));
+
+		upper = IN_RANGE256(v, 'A', 'Z');
+		letter = _mm256_or_si256(upper, IN_RANGE256(v, 'a', 'z'));
+		apos = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\''));
+		space = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), IN_RANGE256(v, '\t', '\r'));
+		punct = _mm256_or_si256(_mm256_or_si256(IN_RANGE256(v, '!', '/'), IN_RANGE256(v, ':', '@')),
+				_mm256_or_si256(IN_RANGE256(v, '[', '`'), IN_RANGE256(v, '{', '~')));
+		sep = _mm256_or_si256(space, _mm256_andnot_si256(apos, punct));
+		bad = _mm256_andnot_si256(_mm256_or_si256(_mm256_or_si256(sep, letter), apos), _mm256_set1_epi8(-1));
+
+		_mm256_storeu_si256((__m256i *) (lower + i), _mm256_add_epi8(v, _mm256_and_si256(upper, _mm256_set1_epi8(0x20))));
+
+		m_sep |= (uint64_t) (unsigned) _mm256_movemask_epi8(sep) << i;
+		m_bad |= (uint64_t) (unsigned) _mm256_movemask_epi8(bad) << i;
+		m_nl |= (uint64_t) (unsigned) _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))) << i;
+	}
+	masks->sep = m_sep;
+	masks->bad = m_bad;
+	masks->nl = m_nl;
+}
+
+#endif
+
+
+/**
+ *
+ * Builds the scalar tables and picks the best kernel supported by the cpu.
+ * Called once, the first time the tokenizer is used.
+ *
+ */
+static void initTokenizer(void){
+	int c;
+
+	for (c = 0; c < 256; c++) {
+		classTable[c] = 0;
+		if (isspace(c) || (ispunct(c) && c != '\'')) classTable[c] |= CLASS_SEP;
+		else if (iscntrl(c) || !isascii(c) || isdigit(c)) classTable[c] |= CLASS_BAD;
+		if (c == '\n') classTable[c] |= CLASS_NL;
+		lowerTable[c] = isupper(c) ? tolower(c) : c;
+	}
+
+	if (currentKernel == TOKENIZER_AUTO) {
+		currentKernel = TOKENIZER_SCALAR;
+		classifyBlock = classifyBlockScalar;
+#if defined(__x86_64__) || defined(__i386__)
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2")) {
+			currentKernel = TOKENIZER_AVX2;
+			classifyBlock = classifyBlockAVX2;
+		} else if (__builtin_cpu_supports("sse2")) {
+			currentKernel = TOKENIZER_SSE2;
+			classifyBlock = classifyBlockSSE2;
+		}
+#endif
+	}
+}
+
+
+/**
+ *
+ * Forces one kernel. TOKENIZER_AUTO goes back to the best one available.
+ * Returns -1 if the cpu does not support the requested kernel. It is meant
+ * to be called before the threads start tokenizing.
+ *
+ */
+int setTokenizerKernel(TokenizerKernel kernel){
+	pthread_once(&tokenizerOnce, initTokenizer);
+
+	switch (kernel) {
+		case TOKENIZER_AUTO:
+			currentKernel = TOKENIZER_AUTO;
+			initTokenizer();
+			return 0;
+		case TOKENIZER_CTYPE:
+			classifyBlock = NULL;
+			break;
+		case TOKENIZER_SCALAR:
+			classifyBlock = classifyBlockScalar;
+			break;
+#if defined(__x86_64__) || defined(__i386__)
+		case TOKENIZER_SSE2:
+			if (!__builtin_cpu_supports("sse2")) return -1;
+			classifyBlock = classifyBlockSSE2;
+			break;
+		case TOKENIZER_AVX2:
+			if (!__builtin_cpu_supports("avx2")) return -1;
+			classifyBlock = classifyBlockAVX2;
+			break;
+#endif
+		default:
+			return -1;
+	}
+	currentKernel = kernel;
+	return 0;
+}
+
+
+/**
+ *
+ * Returns the name of the kernel in use.
+ *
+ */
+const char *getTokenizerKernelName(void){
+	pthread_once(&tokenizerOnce, initTokenizer);
+
+	switch (currentKernel) {
+		case TOKENIZER_CTYPE: return "ctype";
+		case TOKENIZER_SCALAR: return "scalar";
+		case TOKENIZER_SSE2: return "sse2";
+		case TOKENIZER_AVX2: return "avx2";
+		default: return "auto";
+	}
+}
+
+
+/**
+ *
+ * Returns the bits from position first to last-1.
+ *
+ */
+static inline uint64_t rangeMask(int first, int last){
+	uint64_t high = (last == 64) ? ~(uint64_t) 0 : ((uint64_t) 1 << last) - 1;
+	return high & ~(((uint64_t) 1 << first) - 1);
+}
+
+
+/**
+ *
+ * Applies the rules of findWordsCtype to a classified block. Instead of
+ * looking at every byte it jumps from one run of word characters to the
+ * next run of separators with the masks.
+ *
+ * While a word grows, every letter beyond MAX_WORDCHR resets the buffer,
+ * so after n letters the length is (j + n) % (MAX_WORDCHR + 1) and the
+ * buffer holds the last letters of the run.
+ *
+ */
+static void walkBlock(unsigned char *lower, const BlockMasks *masks, WordState *st, HashTable *hashTable){
+	uint64_t rest, run;
+	int p = 0, e, n;
+
+	while (p < BLOCKSIZE) {
+		rest = masks->sep >> p;
+
+		if (!(rest & 1)) {	/* tros de paraula fins al seguent separador */
+			e = rest ? p + __builtin_ctzll(rest) : BLOCKSIZE;
+			run = rangeMask(p, e);
+
+			/*
+			 * Cas habitual: la paraula sencera es dins del bloc i es valida.
+			 * S'insereix directament des del bloc, posant el final de cadena
+			 * sobre el separador, i el separador ja no es torna a tractar.
+			 */
+			if (st->j == 0 && st->validate && e < BLOCKSIZE && e - p <= MAX_WORDCHR && !(masks->bad & run)) {
+				lower[e] = '\0';
+				insertHashTable(hashTable, (char *) lower + p, e - p, getHashValue((char *) lower + p, e - p));
+				p = e + 1;
+				continue;
+			}
+
+			if (masks->bad & run) st->validate = 0;
+			n = e - p - __builtin_popcountll(masks->bad & run);
+
+			if (!st->validate) {
+				st->j = (st->j + n) % (MAX_WORDCHR + 1);
+			} else if (st->j + n <= MAX_WORDCHR) {
+				memcpy(st->word + st->j, lower + p, n);
+				st->j += n;
+			} else {
+				st->j = (st->j + n) % (MAX_WORDCHR + 1);
+				memcpy(st->word, lower + e - st->j, st->j);
+			}
+
+		} else {			/* tros de separadors */
+			rest = ~masks->sep >> p;
+			e = rest ? p + __builtin_ctzll(rest) : BLOCKSIZE;
+
+			if (st->j > 0) {
+				st->word[st->j] = '\0';
+				if (st->validate) insertHashTable(hashTable, st->word, st->j, getHashValue(st->word, st->j));
+				st->validate = 1;
+				st->j = 0;
+			}
+			if (masks->nl & rangeMask(p, e)) st->validate = 1;
+		}
+		p = e;
+	}
+}
+
+
+/**
+ *
+ * Donat un buffer de size caràcters, cerca paraules seguint els criteris
+ * especificats i les guarda a la hashTable. Fa servir el nucli per blocs
+ * triat en temps d'execucio (AVX2, SSE2 o escalar). L'ultim bloc s'omple
+ * amb espais, que son separadors.
+ *
+ */
+HashTable *findWords(const char *buffer, size_t size, HashTable *hashTable){
+	unsigned char tail[BLOCKSIZE], lower[BLOCKSIZE];
+	const unsigned char *in = (const unsigned char *) buffer;
+	BlockMasks masks;
+	WordState st;
+	size_t i;
+
+	pthread_once(&tokenizerOnce, initTokenizer);
+	if (classifyBlock == NULL) return findWordsCtype(buffer, size, hashTable);
+
+	st.j = 0;
+	st.validate = 1;
+
+	for (i = 0; i + BLOCKSIZE <= size; i += BLOCKSIZE) {
+		classifyBlock(in + i, lower, &masks);
+		walkBlock(lower, &masks, &st, hashTable);
+	}
+
+	if (i < size) {
+		memset(tail, ' ', BLOCKSIZE);
+		memcpy(tail, in + i, size - i);
+		classifyBlock(tail, lower, &masks);
+		walkBlock(lower, &masks, &st, hashTable);
+	}
+
+	if (st.j > 0 && st.validate) {	//el final del buffer tanca l'ultima paraula
+		st.word[st.j] = '\0';
+		insertHashTable(hashTable, st.word, st.j, getHashValue(st.word, st.j));
+	}
+
+	return hashTable;
+}
+
+
+/**
+ *
+ * Splits the buffer in up to numChunks pieces of about the same size, to
+ * be tokenized by different threads with findWords. Every piece but the
+ * last one ends just after a '\n': a new line starts with no word and a
+ * clean state, so each piece finds exactly the words that the serial pass
+ * would find there. The tables of the pieces are not set. Returns the
+ * number of pieces, at least one even if the buffer is empty.
+ *
+ */
+int splitWordChunks(const char *buffer, size_t size, WordChunk *chunks, int numChunks){
+	size_t start = 0, end;
+	const char *nl;
+	int n = 0;
+
+	if (numChunks > TOKENIZER_MAXCHUNKS) numChunks = TOKENIZER_MAXCHUNKS;
+	if (numChunks < 1) numChunks = 1;
+
+	do {	//almenys un tros, encara que el buffer sigui buit
+		end = (n == numChunks - 1) ? size : size / numChunks * (n + 1);
+		if (end < start) end = start;
+		if (end < size) {	//el tros acaba despres del seguent salt de linia
+			nl = memchr(buffer + end, '\n', size - end);
+			end = nl ? (size_t) (nl - buffer) + 1 : size;
+		}
+		chunks[n].buffer = buffer + start;
+		chunks[n].size = end - start;
+		chunks[n].hashTable = NULL;
+		n++;
+		start = end;
+	} while (start < size);
+
+	return n;
+}
@@ -0,0 +1,89 @@
+/**
+ *
+ * Tokenizer header
+ *
+ * Include this file in order to be able to call the
+ * functions available in tokenizer.c. We include
+ * here only those information we want to make visible
+ * to other files.
+ *
+ * Igor Dzinka / Vicent Roig, 2014.
+ *
+ */
+#ifndef TOKENIZER_H
+#define TOKENIZER_H
+
+#include <stddef.h>
+#include "hash-table.h"
+
+/**
+ *
+ * When USE_MMAP is 1 the files are mapped in memory with mmap. With 0
+ * (or if mmap fails) the whole file is read into a single buffer. In both
+ * cases the text is tokenized in one pass, without splitting it in lines.
+ *
+ */
+#define USE_MMAP 1
+
+/**
+ *
+ * A file is tokenized by several threads only if each of them gets at
+ * least TOKENIZER_CHUNKSIZE bytes, and by TOKENIZER_MAXCHUNKS at most.
+ *
+ */
+#define TOKENIZER_CHUNKSIZE (4 * 1024 * 1024)
+#define TOKENIZER_MAXCHUNKS 64
+
+/**
+ *
+ * Kernels that can classify the characters. TOKENIZER_CTYPE is the
+ * original byte by byte loop and is kept as a reference. By default the
+ * fastest one supported by the cpu is used.
+ *
+ */
+typedef enum {
+	TOKENIZER_AUTO,
+	TOKENIZER_CTYPE,
+	TOKENIZER_SCALAR,
+	TOKENIZER_SSE2,
+	TOKENIZER_AVX2
+} TokenizerKernel;
+
+/**
+ *
+ * Contents of a file ready to be tokenized. "mapped" tells how the memory
+ * has to be released.
+ *
+ */
+typedef struct MappedFile_ {
+	char *data;		/* contingut del fitxer */
+	size_t size;	/* nombre de bytes */
+	int mapped;		/* 1 si data prove de mmap, 0 si de malloc */
+} MappedFile;
+
+/**
+ *
+ * Piece of a buffer given by splitWordChunks, tokenized into its own
+ * table.
+ *
+ */
+typedef struct WordChunk_ {
+	const char *buffer;
+	size_t size;
+	HashTable *hashTable;
+} WordChunk;
+
+/**
+ *
+ * Function heders we want to make visible so that they
+ * can be called from any other file.
+ *
+ */
+int mapFile(char *filename, MappedFile *file);
+void unmapFile(MappedFile *file);
+HashTable *findWords(const char *buffer, size_t size, HashTable *hashTable);
+int splitWordChunks(const char *buffer, size_t size, WordChunk *chunks, int numChunks);
+int setTokenizerKernel(TokenizerKernel kernel);
+const char *getTokenizerKernelName(void);
+
+#endif
@@ -0,0 +1,202 @@
+/**
+ *
+ * Trace implementation.
+ *
+ * Timeline of the threads of the build, written in the trace event format
+ * of Chrome (chrome://tracing, Perfetto): one row per thread, with the
+ * spans of every file and every phase.
+ *
+ * Igor Dzinka / Vicent Roig, 2014.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+/**
+ * We include the trace.h header. Note the double
+ * quotes.
+ */
+#include "trace.h"
+#include "metrics.h"
+
+int traceEnabled = 0;
+
+static pthread_mutex_t lockTrace = PTHREAD_MUTEX_INITIALIZER;
+static TraceBuffer *allBuffers = NULL;		//els de tots els fils, el mes nou primer
+static int numBuffers = 0;
+static int generation = 0;					//canvia a cada startTrace
+static uint64_t startNs;
+
+static __thread TraceBuffer *localBuffer = NULL;
+static __thread int localGeneration;
+
+
+static TraceBlock *allocTraceBlock(void){
+	TraceBlock *block;
+
+	if ((block = malloc(sizeof(TraceBlock))) == NULL) {
+		printf("insufficient memory (allocTraceBlock)\n");
+		exit(1);
+	}
+	block->numEvents = 0;
+	block->next = NULL;
+	return block;
+}
+
+
+/**
+ *
+ * Returns the buffer of the calling thread, creating it the first time
+ * the thread records something after startTrace.
+ *
+ */
+static TraceBuffer *getTraceBuffer(void){
+	TraceBuffer *buffer = localBuffer;
+
+	if (buffer != NULL && localGeneration == generation) return buffer;
+
+	if ((buffer = malloc(sizeof(TraceBuffer))) == NULL) {
+		printf("insufficient memory (getTraceBuffer)\n");
+		exit(1);
+	}
+	buffer->first = buffer->last = allocTraceBlock();
+	buffer->name[0] = '\0';
+
+	pthread_mutex_lock(&lockTrace);
+	buffer->tid = ++numBuffers;
+	buffer->next = allBuffers;
+	allBuffers = buffer;
+	localGeneration = generation;
+	pthread_mutex_unlock(&lockTrace);
+
+	localBuffer = buffer;
+	return buffer;
+}
+
+
+/**
+ *
+ * Adds an event to the buffer of the calling thread. It is called by the
+ * macros of trace.h only when the trace is started.
+ *
+ */
+void addTraceEvent(char phase, const char *name, int arg){
+	TraceBuffer *buffer = getTraceBuffer();
+	TraceBlock *block = buffer->last;
+	TraceEvent *event;
+
+	if (block->numEvents == TRACE_BLOCKSIZE) {
+		block->next = allocTraceBlock();
+		block = buffer->last = block->next;
+	}
+
+	event = &(block->events[block->numEvents++]);
+	event->ns = getMetricsTime() - startNs;
+	event->name = name;
+	event->arg = arg;
+	event->phase = phase;
+}
+
+
+/**
+ *
+ * Names the row of the calling thread in the timeline, as role num (only
+ * role if num is negative).
+ *
+ */
+void setTraceThreadName(const char *role, int num){
+	if (num < 0) snprintf(getTraceBuffer()->name, TRACE_NAMELEN, "%s", role);
+	else snprintf(getTraceBuffer()->name, TRACE_NAMELEN, "%s %d", role, num);
+}
+
+
+static void freeTraceBuffers(void){
+	TraceBuffer *buffer;
+	TraceBlock *block;
+
+	while ((buffer = allBuffers) != NULL) {
+		allBuffers = buffer->next;
+		while ((block = buffer->first) != NULL) {
+			buffer->first = block->next;
+			free(block);
+		}
+		free(buffer);
+	}
+	numBuffers = 0;
+}
+
+
+/**
+ *
+ * Forgets the events recorded so far and starts recording. It can not be
+ * called while other threads are recording.
+ *
+ */
+void startTrace(void){
+	pthread_mutex_lock(&lockTrace);
+	freeTraceBuffers();
+	generation++;
+	startNs = getMetricsTime();
+	pthread_mutex_unlock(&lockTrace);
+
+	traceEnabled = 1;
+	setTraceThreadName("main", -1);
+}
+
+
+/**
+ *
+ * Stops recording. The events are kept until the next startTrace.
+ *
+ */
+void stopTrace(void){
+	traceEnabled = 0;
+}
+
+
+/**
+ *
+ * Writes the events recorded between startTrace and stopTrace to the file
+ * filename, as a JSON trace. The timestamps are in microseconds. Returns
+ * 0 on success.
+ *
+ */
+int saveTrace(char *filename){
+	TraceBuffer *buffer;
+	TraceBlock *block;
+	TraceEvent *event;
+	FILE *fp;
+	int i, first = 1;
+
+	if ((fp = fopen(filename, "w")) == NULL) return -1;
+
+	pthread_mutex_lock(&lockTrace);
+	fprintf(fp, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+	for (buffer = allBuffers; buffer != NULL; buffer = buffer->next) {
+		if (buffer->name[0]) {
+			fprintf(fp, "%s\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": \"%s\"}}",
+					first ? "" : ",", buffer->tid, buffer->name);
+			fprintf(fp, ",\n{\"name\": \"thread_sort_index\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"sort_index\": %d}}",
+					buffer->tid, buffer->tid);
+			first = 0;
+		}
+
+		for (block = buffer->first; block != NULL; block = block->next) {
+			for (i = 0; i < block->numEvents; i++) {
+				event = &(block->events[i]);
+				fprintf(fp, "%s\n{\"name\": \"%s\", \"ph\": \"%c\", \"ts\": %.3f, \"pid\": 1, \"tid\": %d",
+						first ? "" : ",", event->name, event->phase, event->ns * 1e-3, buffer->tid);
+				if (event->arg >= 0) fprintf(fp, ", \"args\": {\"file\": %d}", event->arg);
+				fprintf(fp, "}");
+				first = 0;
+			}
+		}
+	}
+	fprintf(fp, "\n]}\n");
+	pthread_mutex_unlock(&lockTrace);
+
+	return fclose(fp) == 0 ? 0 : -1;
+}
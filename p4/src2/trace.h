@@ -0,0 +1,101 @@
+/**
+ *
+ * Trace header
+ *
+ * Include this file in order to be able to call the
+ * functions available in trace.c. We include
+ * here only those information we want to make visible
+ * to other files.
+ *
+ * Igor Dzinka / Vicent Roig, 2014.
+ *
+ */
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+/**
+ *
+ * With TRACE 1 (the default) the build can record a timeline of what every
+ * thread is doing, between startTrace and stopTrace. While it is stopped
+ * every event costs a test of traceEnabled. With TRACE 0 the macros are
+ * empty.
+ *
+ */
+#ifndef TRACE
+#define TRACE 1
+#endif
+
+/**
+ *
+ * Events per block of the buffer of a thread. A full block is not copied:
+ * a new one is chained after it.
+ *
+ */
+#define TRACE_BLOCKSIZE 4096
+
+#define TRACE_NAMELEN 32
+
+/**
+ *
+ * Begin ('B') or end ('E') of a span of a thread. name has to be a
+ * constant string; arg is a file id, or -1.
+ *
+ */
+typedef struct TraceEvent_ {
+	uint64_t ns;			/* temps des de startTrace */
+	const char *name;
+	int arg;
+	char phase;
+} TraceEvent;
+
+typedef struct TraceBlock_ {
+	TraceEvent events[TRACE_BLOCKSIZE];
+	int numEvents;
+	struct TraceBlock_ *next;
+} TraceBlock;
+
+/**
+ *
+ * Events of one thread. Only the thread writes in it, so no locks are
+ * needed; the buffers are read once the threads have finished.
+ *
+ */
+typedef struct TraceBuffer_ {
+	TraceBlock *first;
+	TraceBlock *last;
+	int tid;						/* ordre d'arribada del fil */
+	char name[TRACE_NAMELEN];
+	struct TraceBuffer_ *next;
+} TraceBuffer;
+
+#if TRACE
+
+extern int traceEnabled;
+
+#define TRACE_BEGIN(name, arg) do { if (__builtin_expect(traceEnabled, 0)) addTraceEvent('B', name, arg); } while (0)
+#define TRACE_END(name) do { if (__builtin_expect(traceEnabled, 0)) addTraceEvent('E', name, -1); } while (0)
+#define TRACE_THREAD(role, num) do { if (__builtin_expect(traceEnabled, 0)) setTraceThreadName(role, num); } while (0)
+
+#else
+
+#define TRACE_BEGIN(name, arg)
+#define TRACE_END(name)
+#define TRACE_THREAD(role, num)
+
+#endif
+
+/**
+ *
+ * Function heders we want to make visible so that they
+ * can be called from any other file.
+ *
+ */
+void addTraceEvent(char phase, const char *name, int arg);
+void setTraceThreadName(const char *role, int num);
+void startTrace(void);
+void stopTrace(void);
+int saveTrace(char *filename);
+
+#endif
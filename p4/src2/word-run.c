@@ -0,0 +1,140 @@
+/**
+ *
+ * Word run implementation.
+ *
+ * Sorted lists of words used to build the index by merging: the table of
+ * each file is turned into a run, and pairs of runs are merged until only
+ * one run with all the words of the database is left.
+ *
+ * Igor Dzinka / Vicent Roig, 2014.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * We include the word-run.h header. Note the double
+ * quotes.
+ */
+#include "word-run.h"
+
+
+static int compareEntries(const void *a, const void *b){
+	return strcmp(((const RBData *) a)->primary_key, ((const RBData *) b)->primary_key);
+}
+
+
+/**
+ *
+ * Returns a new empty run.
+ *
+ */
+static WordRun *newWordRun(int numEntries){
+	WordRun *run;
+
+	run = malloc(sizeof(WordRun));
+	if (run)
+		run->entries = malloc(sizeof(RBData) * (numEntries + 1));
+	if (run == NULL || run->entries == NULL) {
+		printf("insufficient memory (newWordRun)\n");
+		exit(1);
+	}
+	run->numEntries = 0;
+	initArena(&(run->arena), 0);
+
+	return run;
+}
+
+
+/**
+ *
+ * Builds the run of file idFile from its hash table. The run takes the
+ * arena of the table, so the keys are not copied; the table has still to
+ * be freed by the caller. A NULL table (the file could not be read) gives
+ * an empty run.
+ *
+ */
+WordRun *allocWordRun(HashTable *hashtable, int idFile){
+	WordRun *run;
+	HashEntry *entry;
+	RBData *data;
+	int i;
+
+	if (hashtable == NULL) return newWordRun(0);
+
+	run = newWordRun(hashtable->numItems);
+	moveArena(&(run->arena), &(hashtable->keys));
+
+	for (i = 0; i < hashtable->size; i++) {
+		entry = &(hashtable->entries[i]);
+		if (entry->primary_key == NULL) continue;
+
+		data = &(run->entries[run->numEntries++]);
+		data->primary_key = entry->primary_key;
+		data->hash = entry->hash;
+		data->numFiles = 1;
+		initPostingList(&(data->postings));
+		addPosting(&(data->postings), &(run->arena), idFile, entry->numTimes);
+	}
+
+	qsort(run->entries, run->numEntries, sizeof(RBData), compareEntries);
+	return run;
+}
+
+
+/**
+ *
+ * Merges two runs into a new one and frees them. All the files of b have
+ * to come after the files of a, so the postings of b are appended at the
+ * end of the postings of a. The keys are not copied: the new run takes
+ * the arenas of a and b.
+ *
+ */
+WordRun *mergeWordRuns(WordRun *a, WordRun *b){
+	WordRun *run;
+	PostingIterator it;
+	RBData *data;
+	int i = 0, j = 0, cmp;
+
+	run = newWordRun(a->numEntries + b->numEntries);
+	moveArena(&(run->arena), &(a->arena));
+	moveArena(&(run->arena), &(b->arena));
+
+	while (i < a->numEntries || j < b->numEntries) {
+		if (i == a->numEntries) cmp = 1;
+		else if (j == b->numEntries) cmp = -1;
+		else cmp = strcmp(a->entries[i].primary_key, b->entries[j].primary_key);
+
+		data = &(run->entries[run->numEntries++]);
+		if (cmp < 0) {
+			*data = a->entries[i++];
+		} else if (cmp > 0) {
+			*data = b->entries[j++];
+		} else {
+			// la paraula es als dos costats: afegim els fitxers de b darrere dels de a
+			*data = a->entries[i++];
+			data->numFiles += b->entries[j].numFiles;
+
+			initPostingIterator(&it, &(b->entries[j++].postings));
+			while (nextPosting(&it)) addPosting(&(data->postings), &(run->arena), it.fileId, it.numTimes);
+		}
+	}
+
+	freeWordRun(a);
+	freeWordRun(b);
+	return run;
+}
+
+
+/**
+ *
+ * Frees the run and its arena.
+ *
+ */
+void freeWordRun(WordRun *run){
+	deleteArena(&(run->arena));
+	free(run->entries);
+	free(run);
+}
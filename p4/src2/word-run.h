@@ -0,0 +1,41 @@
+/**
+ *
+ * Word run header
+ *
+ * Include this file in order to be able to call the
+ * functions available in word-run.c. We include
+ * here only those information we want to make visible
+ * to other files.
+ *
+ * Igor Dzinka / Vicent Roig, 2014.
+ *
+ */
+#ifndef WORD_RUN_H
+#define WORD_RUN_H
+
+#include "red-black-tree.h"
+
+/**
+ *
+ * A run is the list of words of a range of files of the database, sorted
+ * alphabetically. Each entry has the same fields as the data of a node of
+ * the tree. The keys and the postings live in the arena of the run.
+ *
+ */
+typedef struct WordRun_ {
+	RBData *entries;		/* paraules ordenades */
+	int numEntries;
+	Arena arena;			/* paraules i llistes de fitxers */
+} WordRun;
+
+/**
+ *
+ * Function heders we want to make visible so that they
+ * can be called from any other file.
+ *
+ */
+WordRun *allocWordRun(HashTable *hashtable, int idFile);
+WordRun *mergeWordRuns(WordRun *a, WordRun *b);
+void freeWordRun(WordRun *run);
+
+#endif